@@ -0,0 +1,184 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+
+#include <benchmark/benchmark.h>
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief hardware counters of the calling thread (and the threads it spawns) through perf_event_open
+ *
+ * Counters the kernel or the machine does not provide (containers, VMs without a virtual PMU,
+ * perf_event_paranoid > 2, non Linux systems) are reported as unavailable and simply left out.
+ */
+struct PerfCounters {
+    enum Event {
+        cycles, instructions, branch_misses, l1d_misses, llc_misses, event_count
+    };
+
+    static constexpr std::array<const char*, event_count> names = {
+            "cycles", "instructions", "branch-misses", "L1D-misses", "LLC-misses"
+    };
+
+    /**
+     * set by `--perf_counters` on the benchmark command line
+     */
+    static inline bool enabled = false;
+
+    PerfCounters() {
+#if defined(__linux__)
+        constexpr uint64_t cache_miss = PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16;
+        const std::array<std::pair<uint32_t, uint64_t>, event_count> configs = {{
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+                {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | cache_miss},
+                {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cache_miss},
+        }};
+
+        for (size_t i = 0; i < event_count; i++) {
+            perf_event_attr attr{};
+            attr.size = sizeof(attr);
+            attr.type = configs[i].first;
+            attr.config = configs[i].second;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+#endif
+    }
+
+    ~PerfCounters() {
+#if defined(__linux__)
+        for (int fd: fds) {
+            if (fd >= 0) close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    [[nodiscard]] bool available(Event event) const {
+        return fds[event] >= 0;
+    }
+
+    [[nodiscard]] bool any_available() const {
+        for (int fd: fds) {
+            if (fd >= 0) return true;
+        }
+        return false;
+    }
+
+    void start() {
+#if defined(__linux__)
+        for (int fd: fds) {
+            if (fd < 0) continue;
+            ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+
+    void stop() {
+#if defined(__linux__)
+        for (size_t i = 0; i < event_count; i++) {
+            if (fds[i] < 0) continue;
+            ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+            // value, time enabled, time running; scaled up when the counter was multiplexed
+            uint64_t buffer[3] = {};
+            if (read(fds[i], buffer, sizeof(buffer)) != sizeof(buffer) or buffer[2] == 0) {
+                values[i] = 0;
+                continue;
+            }
+            values[i] = static_cast<double>(buffer[0]) * static_cast<double>(buffer[1]) / static_cast<double>(buffer[2]);
+        }
+#endif
+    }
+
+    [[nodiscard]] double value(Event event) const {
+        return values[event];
+    }
+
+    std::array<int, event_count> fds{-1, -1, -1, -1, -1};
+    std::array<double, event_count> values{};
+};
+
+/**
+ * @brief counts around the timed loop of a benchmark and adds the results to its counters
+ *
+ * Construct it right before `for (auto _: state)` and call `report` after the loop. Does nothing
+ * unless `PerfCounters::enabled`.
+ */
+struct PerfScope {
+    explicit PerfScope(benchmark::State& state) : state(state) {
+        if (PerfCounters::enabled) {
+            counters.emplace();
+            counters->start();
+        }
+    }
+
+    /**
+     * @param limb_products nominal 64 x 64-bit products per iteration (the schoolbook count), 0 if not meaningful
+     */
+    void report(double limb_products = 0) {
+        if (not counters.has_value() or not counters->any_available()) return;
+        auto& counters = *this->counters;
+        counters.stop();
+
+        auto iterations = static_cast<double>(state.iterations());
+        for (size_t i = 0; i < PerfCounters::event_count; i++) {
+            auto event = static_cast<PerfCounters::Event>(i);
+            if (counters.available(event)) {
+                state.counters[PerfCounters::names[i]] = counters.value(event) / iterations;
+            }
+        }
+
+        if (counters.available(PerfCounters::cycles) and counters.available(PerfCounters::instructions) and
+            counters.value(PerfCounters::cycles) > 0) {
+            state.counters["IPC"] = counters.value(PerfCounters::instructions) / counters.value(PerfCounters::cycles);
+        }
+        if (counters.available(PerfCounters::cycles) and limb_products > 0) {
+            state.counters["cycles/limb-product"] = counters.value(PerfCounters::cycles) / iterations / limb_products;
+        }
+    }
+
+    benchmark::State& state;
+    std::optional<PerfCounters> counters;
+};
+
+/**
+ * @brief remove `--perf_counters` from the command line and enable the counters, before benchmark::Initialize
+ */
+inline void parse_perf_counters_flag(int& argc, char** argv) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--perf_counters") == 0) {
+            PerfCounters::enabled = true;
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+
+    if (PerfCounters::enabled and not PerfCounters().any_available()) {
+        std::fprintf(stderr, "perf_event_open is not available here (check perf_event_paranoid), "
+                             "running without hardware counters\n");
+    }
+}
@@ -1,41 +1,530 @@
 #include <benchmark/benchmark.h>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <optional>
 
 #include "rsa.hpp"
+#include "verification_cache.hpp"
+
+#include "perf_counters.hpp"
 
 constexpr int len = 6;
 
+/**
+ * heap allocations of the whole process, reported by the benchmarks below as allocs per iteration
+ */
+static std::atomic<size_t> allocation_count{0};
+
+/**
+ * every replaceable form of operator new / delete goes through these two, so that no allocation bypasses the
+ * count and every delete matches its new; not inlined, so the compiler never pairs a visible free with a new
+ */
+[[gnu::noinline]] static void* counted_allocate(size_t size, size_t alignment) noexcept {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    size = std::max<size_t>(size, 1);
+    if (alignment <= alignof(std::max_align_t)) {
+        return std::malloc(size);
+    }
+    return std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+}
+
+[[gnu::noinline]] static void counted_release(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+static void* counted_allocate_or_throw(size_t size, size_t alignment) {
+    if (void* ptr = counted_allocate(size, alignment)) return ptr;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size) { return counted_allocate_or_throw(size, 0); }
+void* operator new[](size_t size) { return counted_allocate_or_throw(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment) { return counted_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment) { return counted_allocate_or_throw(size, static_cast<size_t>(alignment)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return counted_allocate(size, 0); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return counted_allocate(size, 0); }
+void* operator new(size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_allocate(size, static_cast<size_t>(alignment)); }
+void* operator new[](size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept { return counted_allocate(size, static_cast<size_t>(alignment)); }
+
+void operator delete(void* ptr) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr) noexcept { counted_release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { counted_release(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { counted_release(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { counted_release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { counted_release(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_release(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { counted_release(ptr); }
+
+static double limbs(int64_t bits) {
+    return static_cast<double>(bits) / 64;
+}
+
+/**
+ * one Montgomery square (product and reduction) per exponent bit
+ */
+static double modexp_limb_products(int64_t bits) {
+    return static_cast<double>(bits) * 2 * limbs(bits) * limbs(bits);
+}
+
+/**
+ * set by `--random_seed=N`, the key generation benchmarks then draw from seeded streams; the candidates only
+ * repeat from run to run with a single search thread, see `Random::seed`
+ */
+static std::optional<uint64_t> random_seed;
+
+static void reseed_random() {
+    if (random_seed.has_value()) {
+        Random::seed(*random_seed);
+    }
+}
+
 static void rsa_768_benchmark(benchmark::State& state) {
+    reseed_random();
     RSA<BigInt> rsa_manager;
+    PerfScope perf(state);
     for (auto _: state) {
         rsa_manager.generate_key_pair(768);
     }
+    perf.report();
 }
 
 static void rsa_1024_benchmark(benchmark::State& state) {
+    reseed_random();
     RSA<BigInt> rsa_manager;
+    PerfScope perf(state);
     for (auto _: state) {
         rsa_manager.generate_key_pair(1024);
     }
+    perf.report();
 }
 
 static void rsa_2048_benchmark(benchmark::State& state) {
+    reseed_random();
     RSA<BigInt> rsa_manager;
+    PerfScope perf(state);
     for (auto _: state) {
         rsa_manager.generate_key_pair(2048);
     }
+    perf.report();
 }
 
 static void rsa_4096_benchmark(benchmark::State& state) {
+    reseed_random();
     RSA<BigInt> rsa_manager;
+    PerfScope perf(state);
     for (auto _: state) {
         rsa_manager.generate_key_pair(4096);
     }
+    perf.report();
+}
+
+/**
+ * multi-prime RSA: state.range(0) = len (modulus has 2 * len bits), state.range(1) = number of primes
+ */
+static void rsa_multi_prime_keygen_benchmark(benchmark::State& state) {
+    reseed_random();
+    RSA<BigInt> rsa_manager;
+    PerfScope perf(state);
+    for (auto _: state) {
+        rsa_manager.generate_key_pair(state.range(0), state.range(1));
+    }
+    perf.report();
+}
+
+static void rsa_multi_prime_decrypt_benchmark(benchmark::State& state) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(state.range(0), state.range(1));
+    BigInt cipher = rsa_manager.encrypt(BigInt("0x20536f6d652054657874204865726520"));
+    PerfScope perf(state);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(rsa_manager.decrypt(cipher));
+    }
+    perf.report();
+}
+
+/**
+ * state.range(0) = len (modulus has 2 * len bits), state.range(1) = 0 for decrypt without blinding,
+ * 1 for the built-in blinding (squared pair), 2 for blinding with a fresh r per call
+ */
+static void blinding_benchmark(benchmark::State& state) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(state.range(0));
+    rsa_manager.blinding = state.range(1) == 1;
+    BigInt cipher = rsa_manager.encrypt(PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4));
+    const BigInt& n = rsa_manager.public_key.n;
+
+    PerfScope perf(state);
+    for (auto _: state) {
+        if (state.range(1) == 2) {
+            BigInt r = BigInt::random(n.msb() - 1, Random::local());
+            BigInt blinded = (cipher * rsa_manager.public_exp(r)) % n;
+            benchmark::DoNotOptimize((rsa_manager.decrypt(blinded) * rsa_manager.mod_inverse(r, n)) % n);
+        } else {
+            benchmark::DoNotOptimize(rsa_manager.decrypt(cipher));
+        }
+    }
+    perf.report();
+}
+
+/**
+ * Fiat's batch RSA: state.range(0) = len (modulus has 2 * len bits), state.range(1) = batch size,
+ * state.range(2) = 0 for one CRT decryption per cipher, 1 for `batch_decrypt`
+ */
+static void batch_decrypt_benchmark(benchmark::State& state) {
+    std::vector<uint64_t> exponents = {3, 5, 7, 11, 13, 17, 19, 23};
+    exponents.resize(state.range(1));
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(state.range(0), KeyGenOptions{.batch_exponents = exponents});
+
+    // per-item decryption needs the CRT exponents of every e_i, like a server holding one key per exponent
+    std::vector<BigInt> ciphers;
+    std::vector<std::vector<BigInt>> crt_exponents(exponents.size());
+    for (size_t i = 0; i < exponents.size(); i++) {
+        ciphers.push_back(rsa_manager.batch_encrypt(PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4), i));
+        for (const auto& prime: rsa_manager.private_key.primes) {
+            crt_exponents[i].push_back(rsa_manager.mod_inverse(rsa_manager.batch_exponents[i] % (prime - 1), prime - 1));
+        }
+    }
+
+    for (auto _: state) {
+        if (state.range(2)) {
+            benchmark::DoNotOptimize(rsa_manager.batch_decrypt(ciphers));
+        } else {
+            for (size_t i = 0; i < ciphers.size(); i++) {
+                benchmark::DoNotOptimize(ArenaScope::run([&] { return rsa_manager.crt_exp_mod(ciphers[i], crt_exponents[i]); }));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * confirming a prime: state.range(0) = prime bits, state.range(1) = PrimalityTest
+ */
+static void prime_confirm_benchmark(benchmark::State& state) {
+    using Generator = PrimeGenerator<BigInt>;
+    BigInt prime = Generator::get_prime(state.range(0) / 4);
+    auto test = static_cast<PrimalityTest>(state.range(1));
+
+    PerfScope perf(state);
+    for (auto _: state) {
+        auto saved = Generator::primality_test;
+        Generator::primality_test = test;
+        benchmark::DoNotOptimize(Generator::is_prime(prime));
+        Generator::primality_test = saved;
+    }
+    perf.report();
+}
+
+/**
+ * full prime search: state.range(0) = prime bits, state.range(1) = PrimalityTest
+ */
+static void prime_search_benchmark(benchmark::State& state) {
+    reseed_random();
+    using Generator = PrimeGenerator<BigInt>;
+    auto saved = Generator::primality_test;
+    Generator::primality_test = static_cast<PrimalityTest>(state.range(1));
+    PerfScope perf(state);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Generator::get_prime(state.range(0) / 4));
+    }
+    perf.report();
+    Generator::primality_test = saved;
+}
+
+/**
+ * state.range(0) = len, state.range(1) = KeyGenMode
+ */
+static void rsa_keygen_mode_benchmark(benchmark::State& state) {
+    reseed_random();
+    RSA<BigInt> rsa_manager;
+    rsa_manager.keygen_mode = static_cast<KeyGenMode>(state.range(1));
+    PerfScope perf(state);
+    for (auto _: state) {
+        rsa_manager.generate_key_pair(state.range(0));
+    }
+    perf.report();
+}
+
+/**
+ * state.range(0) = operand bits, state.range(1) = 0 for Karatsuba, 1 for NTT
+ */
+static void multiplication_benchmark(benchmark::State& state) {
+    BigInt a = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt b = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+
+    auto saved = BigInt::ntt_threshold;
+    BigInt::ntt_threshold = state.range(1) ? 1 : std::numeric_limits<size_t>::max();
+    PerfScope perf(state);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(a * b);
+    }
+    perf.report(limbs(state.range(0)) * limbs(state.range(0)));
+    BigInt::ntt_threshold = saved;
+}
+
+/**
+ * state.range(0) = operand bits, state.range(1) = 0 for `*`, 1 for `parallel_multiply` over TaskPool::global()
+ */
+static void parallel_multiplication_benchmark(benchmark::State& state) {
+    BigInt a = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt b = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+
+    for (auto _: state) {
+        benchmark::DoNotOptimize(state.range(1) ? a.parallel_multiply(b) : a * b);
+    }
+    state.counters["threads"] = static_cast<double>(TaskPool::global().size() + 1);
+}
+
+/**
+ * 2n / n bit division: state.range(0) = divisor bits, state.range(1) = 0 for Knuth, 1 for Burnikel–Ziegler
+ */
+static void division_benchmark(benchmark::State& state) {
+    BigInt a = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 2);
+    BigInt b = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+
+    auto saved = BigInt::burnikel_ziegler_threshold;
+    if (state.range(1) == 0) BigInt::burnikel_ziegler_threshold = std::numeric_limits<size_t>::max();
+    PerfScope perf(state);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(a % b);
+    }
+    perf.report(limbs(state.range(0)) * limbs(state.range(0)));
+    BigInt::burnikel_ziegler_threshold = saved;
+}
+
+/**
+ * state.range(0) = key length
+ */
+static void keygen_allocation_benchmark(benchmark::State& state) {
+    reseed_random();
+    RSA<BigInt> rsa_manager;
+    size_t before = allocation_count.load();
+    PerfScope perf(state);
+    for (auto _: state) {
+        rsa_manager.generate_key_pair(state.range(0));
+    }
+    perf.report();
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocation_count.load() - before), benchmark::Counter::kAvgIterations);
+}
+
+/**
+ * state.range(0) = modulus bits, full size exponent, state.range(1) = 1 to run each exponentiation in an ArenaScope
+ */
+static void modexp_benchmark(benchmark::State& state) {
+    BigInt mod = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt exp = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+    BigInt base = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+
+    size_t before = allocation_count.load();
+    PerfScope perf(state);
+    for (auto _: state) {
+        if (state.range(1)) {
+            benchmark::DoNotOptimize(ArenaScope::run([&] { return BigInt::fast_odd_exp_mod(base, exp, mod); }));
+        } else {
+            benchmark::DoNotOptimize(BigInt::fast_odd_exp_mod(base, exp, mod));
+        }
+    }
+    perf.report(modexp_limb_products(state.range(0)));
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocation_count.load() - before), benchmark::Counter::kAvgIterations);
+}
+
+using ExpMod = BigInt (*)(const BigInt&, const BigInt&, const BigInt&);
+
+/**
+ * one-shot exponentiation for a modulus of any size, the fixed-size kernel where one applies, without a kept
+ * context (RSA keeps an `ExpModContext` per modulus instead)
+ */
+static ExpMod one_shot_exp_mod(const BigInt& mod) {
+    switch (mod.significant_length()) {
+        case 16: return &BigInt::fixed_odd_exp_mod<16>;
+        case 32: return &BigInt::fixed_odd_exp_mod<32>;
+        case 48: return &BigInt::fixed_odd_exp_mod<48>;
+        case 64: return &BigInt::fixed_odd_exp_mod<64>;
+        default: return &BigInt::fast_odd_exp_mod;
+    }
+}
+
+/**
+ * state.range(0) = modulus bits, through `one_shot_exp_mod` for that size
+ */
+static void fixed_modexp_benchmark(benchmark::State& state) {
+    BigInt mod = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt exp = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+    BigInt base = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+
+    auto exp_mod = one_shot_exp_mod(mod);
+    PerfScope perf(state);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(exp_mod(base, exp, mod));
+    }
+    perf.report(modexp_limb_products(state.range(0)));
+}
+
+/**
+ * state.range(0) = modulus bits, full size exponent, state.range(1) = 0 for the limb Montgomery engine,
+ * 1 for the residue number system one
+ */
+static void rns_modexp_benchmark(benchmark::State& state) {
+    BigInt mod = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt exp = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+    BigInt base = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+
+    ExpMod exp_mod = state.range(1) ? &BigInt::rns_odd_exp_mod : &BigInt::fast_odd_exp_mod;
+    for (auto _: state) {
+        benchmark::DoNotOptimize(exp_mod(base, exp, mod));
+    }
+}
+
+/**
+ * x^65537 mod n: state.range(0) = modulus bits, state.range(1) = 1 for the cached context RSA keeps for
+ * encrypt / verify, 0 for `one_shot_exp_mod` (Montgomery setup on every call)
+ */
+static void public_exp_benchmark(benchmark::State& state) {
+    BigInt mod = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4);
+    BigInt base = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+    BigInt e("0x10001");
+
+    BigInt::ExpModContext context(mod);
+    auto exp_mod = one_shot_exp_mod(mod);
+    PerfScope perf(state);
+    for (auto _: state) {
+        if (state.range(1)) {
+            benchmark::DoNotOptimize(context.pow(base, e));
+        } else {
+            benchmark::DoNotOptimize(exp_mod(base, e, mod));
+        }
+    }
+    perf.report(17 * limbs(state.range(0)) * limbs(state.range(0)) * 2);
+}
+
+/**
+ * verifications spread round robin over 64 public keys of state.range(0) bits, state.range(1) = 1 through a
+ * VerificationCache, 0 through an RSA object per key set up for each verification
+ */
+static void verification_cache_benchmark(benchmark::State& state) {
+    std::vector<RSA<BigInt>::PublicKey> keys;
+    for (int i = 0; i < 64; i++) {
+        keys.push_back({PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4), BigInt("0x10001")});
+    }
+    BigInt digest = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+    BigInt signature = PrimeGenerator<BigInt>::random_odd_integer(state.range(0) / 4 - 1);
+
+    VerificationCache<BigInt> cache;
+    size_t i = 0;
+    PerfScope perf(state);
+    for (auto _: state) {
+        const auto& key = keys[i++ % keys.size()];
+        if (state.range(1)) {
+            benchmark::DoNotOptimize(cache.verify(key, digest, signature));
+        } else {
+            RSA<BigInt> rsa;
+            rsa.public_key = key;
+            rsa.select_kernels();
+            benchmark::DoNotOptimize(rsa.verify(digest, signature));
+        }
+    }
+    perf.report();
+}
+
+/**
+ * state.range(0) = message bytes, state.range(1) = 1 to allow SHA-NI
+ */
+static void sha256_benchmark(benchmark::State& state) {
+    std::string message(state.range(0), 'a');
+    Sha256::use_cpu_extensions = state.range(1);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Sha256::hash(message));
+    }
+    Sha256::use_cpu_extensions = true;
+    state.SetBytesProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * 64 messages of state.range(0) bytes, state.range(1) = 1 to allow SHA-NI or the AVX2 lanes
+ */
+static void sha256_many_benchmark(benchmark::State& state) {
+    std::vector<std::string> storage(64, std::string(state.range(0), 'a'));
+    std::vector<std::string_view> messages(storage.begin(), storage.end());
+    Sha256::use_cpu_extensions = state.range(1);
+    for (auto _: state) {
+        benchmark::DoNotOptimize(Sha256::hash_many(messages));
+    }
+    Sha256::use_cpu_extensions = true;
+    state.SetBytesProcessed(state.iterations() * state.range(0) * 64);
+}
+
+/**
+ * 64 short messages hashed, padded and signed with a 2048-bit key, state.range(0) = 1 for the batch call
+ */
+static void sign_messages_benchmark(benchmark::State& state) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(1024);
+    std::vector<std::string> storage;
+    for (int i = 0; i < 64; i++) storage.push_back("message " + std::to_string(i));
+    std::vector<std::string_view> messages(storage.begin(), storage.end());
+
+    for (auto _: state) {
+        if (state.range(0)) {
+            benchmark::DoNotOptimize(rsa_manager.sign_messages(messages));
+        } else {
+            for (auto message: messages) {
+                benchmark::DoNotOptimize(rsa_manager.sign_message(message));
+            }
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * 64);
 }
 
 BENCHMARK(rsa_768_benchmark);
 BENCHMARK(rsa_1024_benchmark);
 BENCHMARK(rsa_2048_benchmark);
 BENCHMARK(rsa_4096_benchmark);
+BENCHMARK(blinding_benchmark)->ArgsProduct({{1024, 2048}, {0, 1, 2}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(batch_decrypt_benchmark)->ArgsProduct({{1024, 2048}, {2, 4, 8}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(prime_confirm_benchmark)->ArgsProduct({{512, 1024, 2048}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(prime_search_benchmark)->ArgsProduct({{512, 1024}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rsa_keygen_mode_benchmark)->ArgsProduct({{1024, 2048}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(rsa_multi_prime_keygen_benchmark)->ArgsProduct({{1536, 2048}, {2, 3, 4}})->Unit(benchmark::kMillisecond);
+BENCHMARK(rsa_multi_prime_decrypt_benchmark)->ArgsProduct({{1536, 2048}, {2, 3, 4}})->Unit(benchmark::kMillisecond);
+
+BENCHMARK(multiplication_benchmark)->ArgsProduct({benchmark::CreateRange(1 << 14, 1 << 22, 4), {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(parallel_multiplication_benchmark)->ArgsProduct({{1 << 16, 1 << 18, 1 << 20}, {0, 1}})->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(division_benchmark)->ArgsProduct({benchmark::CreateRange(1 << 11, 1 << 18, 4), {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(keygen_allocation_benchmark)->Arg(1024)->Unit(benchmark::kMillisecond);
+BENCHMARK(modexp_benchmark)->ArgsProduct({{1024, 2048, 3072, 4096, 8192}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(fixed_modexp_benchmark)->Arg(1024)->Arg(2048)->Arg(3072)->Arg(4096)->Unit(benchmark::kMillisecond);
+BENCHMARK(rns_modexp_benchmark)->ArgsProduct({{2048, 3072, 4096, 8192}, {0, 1}})->Unit(benchmark::kMillisecond);
+BENCHMARK(public_exp_benchmark)->ArgsProduct({{1024, 2048, 3072, 4096}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(verification_cache_benchmark)->ArgsProduct({{2048, 4096}, {0, 1}})->Unit(benchmark::kMicrosecond);
+BENCHMARK(sha256_benchmark)->ArgsProduct({{64, 1024, 1 << 16}, {0, 1}});
+BENCHMARK(sha256_many_benchmark)->ArgsProduct({{64, 1024}, {0, 1}});
+BENCHMARK(sign_messages_benchmark)->Arg(0)->Arg(1)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+int main(int argc, char** argv) {
+    parse_perf_counters_flag(argc, argv);
+
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (std::strncmp(argv[i], "--random_seed=", 14) == 0) {
+            random_seed = std::strtoull(argv[i] + 14, nullptr, 10);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
 
-BENCHMARK_MAIN();
\ No newline at end of file
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) return 1;
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
\ No newline at end of file
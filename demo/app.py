@@ -1,16 +1,18 @@
-from fastapi import FastAPI, Request, Body
+from fastapi import FastAPI, Request, Body, HTTPException
 from fastapi.responses import HTMLResponse
 from starlette.responses import FileResponse
 from fastapi.staticfiles import StaticFiles
 from fastapi.middleware.cors import CORSMiddleware
 
 import rsa_py as rsa
-import hashlib
 
 app = FastAPI()
 
 rsa_manager = rsa.RSA()
 
+# seconds a key generation request may take
+KEYGEN_TIMEOUT = 30
+
 app.add_middleware(
     CORSMiddleware,
     allow_origins=["*"],
@@ -28,7 +30,10 @@ async def read_root(request: Request):
 
 @app.post("/api/rsa/generate-prime")
 async def generate_keys(payload: dict = Body(...)):
-    res = rsa_manager.generate_key_pair(int(payload["len"]))
+    try:
+        res = rsa_manager.generate_key_pair(int(payload["len"]), timeout=KEYGEN_TIMEOUT)
+    except rsa.SearchCancelled:
+        raise HTTPException(status_code=504, detail="key generation timed out")
     public_key, private_key = res[0], res[1]
     return {
         "p": private_key.p.to_string(),
@@ -61,17 +66,15 @@ async def decrypt(payload: dict = Body(...)):
 
 @app.post("/api/rsa/sign")
 async def sign(payload: dict = Body(...)):
-    hash_text = hashlib.md5(payload["message"].encode(encoding='UTF-8')).hexdigest()
-    result = rsa_manager.sign(rsa.BigInt(hash_text))
+    result = rsa_manager.sign_message(payload["message"])
     return {
         "cipher": result.to_string()
     }
 
 @app.post("/api/rsa/verify")
 async def sign(payload: dict = Body(...)):
-    text = hashlib.md5(payload["text"].encode(encoding='UTF-8')).hexdigest()
     sign = payload["signature"]
-    result = rsa_manager.verify(rsa.BigInt(text), rsa.BigInt(sign))
+    result = rsa_manager.verify_message(payload["text"], rsa.BigInt(sign))
     return {
         "result": result
     }
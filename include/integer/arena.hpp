@@ -0,0 +1,226 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <optional>
+#include <type_traits>
+#include <vector>
+
+/**
+ * @brief thread-local monotonic arena for the heap chunks of Integer temporaries
+ *
+ * While an `ArenaScope` is open on a thread, chunk buffers of that thread come from a bump pointer and
+ * freeing them costs nothing; the whole arena is reset when the outermost scope closes. The blocks are
+ * kept for the next scope, so a steady workload stops touching malloc at all.
+ *
+ * An operation that needs more than `max_bytes` continues on the regular heap, which bounds the memory
+ * held by long operations (e.g. a huge modexp allocates a new product per step).
+ *
+ * Scopes are only opened by `ArenaScope::run`, which copies the result of the operation to the heap before
+ * the arena is reset, so arena memory never leaves the operation. Every buffer records where it came from,
+ * so it can be freed on any thread.
+ */
+struct LimbArena {
+    static constexpr size_t block_size = size_t{1} << 20;
+    static inline size_t max_bytes = size_t{32} << 20;
+
+    static LimbArena& local() {
+        thread_local LimbArena arena;
+        return arena;
+    }
+
+    [[nodiscard]] bool active() const {
+        return depth > 0 and suspended == 0;
+    }
+
+    /**
+     * @return nullptr if the arena is full
+     */
+    void* allocate(size_t bytes, size_t alignment) {
+        bytes = (bytes + alignment - 1) / alignment * alignment;
+        if (used + bytes > max_bytes) return nullptr;
+
+        while (current < blocks.size()) {
+            auto& block = blocks[current];
+            size_t start = (offset + alignment - 1) / alignment * alignment;
+            if (start + bytes <= block.size) {
+                offset = start + bytes;
+                used += bytes;
+                return block.memory.get() + start;
+            }
+            current++;
+            offset = 0;
+        }
+
+        size_t size = std::max(block_size, bytes);
+        blocks.push_back({std::make_unique<std::byte[]>(size), size});
+        offset = bytes;
+        used += bytes;
+        return blocks.back().memory.get();
+    }
+
+    /**
+     * @brief back to `base`, where the outermost scope started
+     */
+    void reset() {
+        current = base.current;
+        offset = base.offset;
+        used = base.used;
+    }
+
+    struct Block {
+        std::unique_ptr<std::byte[]> memory;
+        size_t size;
+    };
+
+    struct Position {
+        size_t current = 0;
+        size_t offset = 0;
+        size_t used = 0;
+    };
+
+    std::vector<Block> blocks;
+    size_t current = 0;
+    size_t offset = 0;
+    size_t used = 0;
+    size_t depth = 0;
+    size_t suspended = 0;
+    /**
+     * start of the memory the outermost scope may reuse, the front of the arena except inside a `TaskArenaFrame`
+     */
+    Position base;
+};
+
+/**
+ * @brief chunk buffers of this thread come from the regular heap meanwhile, even inside an `ArenaScope`
+ *
+ * For values that outlive the current operation, e.g. entries of a cache filled on first use.
+ */
+struct HeapScope {
+    HeapScope() {
+        LimbArena::local().suspended++;
+    }
+
+    ~HeapScope() {
+        LimbArena::local().suspended--;
+    }
+
+    HeapScope(const HeapScope&) = delete;
+    HeapScope& operator=(const HeapScope&) = delete;
+};
+
+/**
+ * @brief a pool task on this thread: starts outside any scope, above the memory of the scopes it interrupts
+ *
+ * Chunk buffers of the task come from the heap, since its results go to another thread, but an
+ * `ArenaScope::run` inside the task uses the arena again. Such a scope only resets the arena back to where
+ * the task started, so a thread that runs a task while waiting inside its own scope keeps that scope's
+ * buffers.
+ */
+struct TaskArenaFrame {
+    TaskArenaFrame() : arena(LimbArena::local()), depth(arena.depth), suspended(arena.suspended), base(arena.base) {
+        arena.depth = 0;
+        arena.suspended = 0;
+        arena.base = {arena.current, arena.offset, arena.used};
+    }
+
+    ~TaskArenaFrame() {
+        arena.reset();
+        arena.depth = depth;
+        arena.suspended = suspended;
+        arena.base = base;
+    }
+
+    TaskArenaFrame(const TaskArenaFrame&) = delete;
+    TaskArenaFrame& operator=(const TaskArenaFrame&) = delete;
+
+private:
+    LimbArena& arena;
+    size_t depth;
+    size_t suspended;
+    LimbArena::Position base;
+};
+
+/**
+ * @brief one top-level operation, chunk buffers of this thread come from its `LimbArena` meanwhile
+ */
+struct ArenaScope {
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+    /**
+     * @brief f() inside a scope, the result is copied to the regular heap before the arena is reset
+     *
+     * Also when nested in another scope, so a result can be stored anywhere.
+     */
+    template<typename F>
+    static auto run(F&& f) {
+        using Result = std::decay_t<std::invoke_result_t<F&>>;
+        if constexpr (std::is_void_v<Result>) {
+            ArenaScope scope;
+            f();
+        } else {
+            std::optional<Result> detached;
+            {
+                ArenaScope scope;
+                Result result = f();
+                HeapScope heap;
+                detached.emplace(result);
+            }
+            return std::move(*detached);
+        }
+    }
+
+private:
+    ArenaScope() {
+        LimbArena::local().depth++;
+    }
+
+    ~ArenaScope() {
+        auto& arena = LimbArena::local();
+        if (--arena.depth == 0) {
+            arena.reset();
+        }
+    }
+};
+
+/**
+ * @brief allocator of Integer chunks, the thread's `LimbArena` while a scope is open and the heap otherwise
+ *
+ * A header in front of every buffer tells the two apart, freeing an arena buffer is a no-op on any thread.
+ */
+template<typename T>
+struct ArenaAllocator {
+    using value_type = T;
+
+    ArenaAllocator() = default;
+
+    template<typename U>
+    ArenaAllocator(const ArenaAllocator<U>&) {}
+
+    T* allocate(size_t n) {
+        size_t bytes = header_size + n * sizeof(T);
+        auto& arena = LimbArena::local();
+        void* block = arena.active() ? arena.allocate(bytes, header_size) : nullptr;
+        bool from_arena = block != nullptr;
+        if (not from_arena) {
+            block = ::operator new(bytes);
+        }
+        ::new (block) bool(from_arena);
+        return reinterpret_cast<T*>(static_cast<std::byte*>(block) + header_size);
+    }
+
+    void deallocate(T* ptr, size_t) {
+        void* block = reinterpret_cast<std::byte*>(ptr) - header_size;
+        if (not *static_cast<bool*>(block)) {
+            ::operator delete(block);
+        }
+    }
+
+    bool operator==(const ArenaAllocator&) const = default;
+
+private:
+    static constexpr size_t header_size = std::max(alignof(std::max_align_t), alignof(T));
+};
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <utility>
+
+/**
+ * @brief Montgomery arithmetic for moduli of exactly N 64-bit limbs (R = 2^(64 N))
+ *
+ * The limb count is a template parameter, so the inner loops over the limbs are unrolled at compile time
+ * and the carry chains are scheduled for the exact size. Used for the standard RSA sizes
+ * (16 / 32 / 48 / 64 limbs), other sizes go through `Integer::MontgomeryContext`.
+ */
+template<size_t N>
+struct FixedMontgomery {
+#if defined(__SIZEOF_INT128__)
+    static constexpr bool available = true;
+
+    using Limbs = std::array<uint64_t, N>;
+    using u128 = unsigned __int128;
+
+    /**
+     * @param mod odd modulus, the highest limb non zero
+     * @param r2 R^2 mod mod
+     */
+    FixedMontgomery(const Limbs& mod, const Limbs& r2) : mod(mod), r2(r2) {
+        uint64_t x = mod[0];
+        for (int i = 0; i < 6; i++) x *= 2 - mod[0] * x;
+        neg_inv = ~x + 1;
+    }
+
+    /**
+     * @brief f(integral_constant<I>) for I = 0 .. Count - 1, expanded at compile time
+     */
+    template<size_t Count, typename F>
+    static void unroll(F&& f) {
+        [&]<size_t... I>(std::index_sequence<I...>) {
+            (f(std::integral_constant<size_t, I>{}), ...);
+        }(std::make_index_sequence<Count>{});
+    }
+
+    /**
+     * @brief a * b * R^-1 mod mod (CIOS, multiplication and reduction interleaved)
+     */
+    Limbs multiply(const Limbs& a, const Limbs& b) const {
+        uint64_t t[N + 2] = {};
+        for (size_t i = 0; i < N; i++) {
+            uint64_t carry = 0;
+            unroll<N>([&](auto j) {
+                u128 s = static_cast<u128>(a[j]) * b[i] + t[j] + carry;
+                t[j] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+            });
+            u128 s = static_cast<u128>(t[N]) + carry;
+            t[N] = static_cast<uint64_t>(s);
+            t[N + 1] = static_cast<uint64_t>(s >> 64);
+
+            uint64_t m = t[0] * neg_inv;
+            carry = static_cast<uint64_t>((static_cast<u128>(m) * mod[0] + t[0]) >> 64);
+            unroll<N - 1>([&](auto j) {
+                u128 s = static_cast<u128>(m) * mod[j + 1] + t[j + 1] + carry;
+                t[j] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+            });
+            s = static_cast<u128>(t[N]) + carry;
+            t[N - 1] = static_cast<uint64_t>(s);
+            t[N] = t[N + 1] + static_cast<uint64_t>(s >> 64);
+        }
+
+        Limbs result;
+        std::copy(t, t + N, result.begin());
+        return final_subtract(result, t[N]);
+    }
+
+    /**
+     * @brief a^2 * R^-1 mod mod, the cross products are computed once and doubled
+     */
+    Limbs square(const Limbs& a) const {
+        uint64_t t[2 * N] = {};
+        for (size_t i = 0; i + 1 < N; i++) {
+            uint64_t carry = 0;
+            for (size_t j = i + 1; j < N; j++) {
+                u128 s = static_cast<u128>(a[i]) * a[j] + t[i + j] + carry;
+                t[i + j] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+            }
+            t[i + N] = carry;
+        }
+
+        uint64_t top = 0;
+        unroll<2 * N>([&](auto i) {
+            uint64_t next = t[i] >> 63;
+            t[i] = (t[i] << 1) | top;
+            top = next;
+        });
+
+        uint64_t carry = 0;
+        unroll<N>([&](auto i) {
+            u128 s = static_cast<u128>(a[i]) * a[i] + t[2 * i] + carry;
+            t[2 * i] = static_cast<uint64_t>(s);
+            s = static_cast<u128>(t[2 * i + 1]) + static_cast<uint64_t>(s >> 64);
+            t[2 * i + 1] = static_cast<uint64_t>(s);
+            carry = static_cast<uint64_t>(s >> 64);
+        });
+
+        return reduce(t);
+    }
+
+    /**
+     * @brief t * R^-1 mod mod for t < mod * R
+     */
+    Limbs reduce(uint64_t (&t)[2 * N]) const {
+        uint64_t extra = 0;
+        for (size_t i = 0; i < N; i++) {
+            uint64_t m = t[i] * neg_inv;
+            uint64_t carry = 0;
+            unroll<N>([&](auto j) {
+                u128 s = static_cast<u128>(m) * mod[j] + t[i + j] + carry;
+                t[i + j] = static_cast<uint64_t>(s);
+                carry = static_cast<uint64_t>(s >> 64);
+            });
+            u128 s = static_cast<u128>(t[i + N]) + carry + extra;
+            t[i + N] = static_cast<uint64_t>(s);
+            extra = static_cast<uint64_t>(s >> 64);
+        }
+
+        Limbs result;
+        std::copy(t + N, t + 2 * N, result.begin());
+        return final_subtract(result, extra);
+    }
+
+    Limbs to_montgomery(const Limbs& a) const {
+        return multiply(a, r2);
+    }
+
+    Limbs from_montgomery(const Limbs& a) const {
+        uint64_t t[2 * N] = {};
+        std::copy(a.begin(), a.end(), t);
+        return reduce(t);
+    }
+
+    /**
+     * @brief base^exp with a fixed 4-bit window, base and the result in Montgomery form
+     * @param exp little-endian limbs of the exponent
+     */
+    Limbs pow(const Limbs& base, const uint64_t* exp, size_t exp_length) const {
+        Limbs one{};
+        one[0] = 1;
+        std::array<Limbs, 16> table;
+        table[0] = to_montgomery(one);
+        table[1] = base;
+        for (size_t i = 2; i < 16; i++) {
+            table[i] = multiply(table[i - 1], base);
+        }
+
+        Limbs result = table[0];
+        bool leading = true;
+        for (size_t i = exp_length; i-- > 0;) {
+            for (int shift = 60; shift >= 0; shift -= 4) {
+                uint64_t window = (exp[i] >> shift) & 0xf;
+                if (not leading) {
+                    result = square(square(square(square(result))));
+                }
+                if (window != 0) {
+                    result = leading ? table[window] : multiply(result, table[window]);
+                    leading = false;
+                }
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief base^exp for an exponent of at most 64 bits (public exponents), square-and-multiply without a table
+     */
+    Limbs pow_small(const Limbs& base, uint64_t exp) const {
+        if (exp == 0) {
+            Limbs one{};
+            one[0] = 1;
+            return to_montgomery(one);
+        }
+
+        Limbs result = base;
+        for (int i = std::bit_width(exp) - 2; i >= 0; i--) {
+            result = square(result);
+            if ((exp >> i) & 1) {
+                result = multiply(result, base);
+            }
+        }
+        return result;
+    }
+
+    Limbs mod;
+    Limbs r2;
+    uint64_t neg_inv;
+
+private:
+    /**
+     * @brief value - mod if [carry, value] >= mod, for [carry, value] < 2 * mod
+     */
+    Limbs final_subtract(const Limbs& value, uint64_t carry) const {
+        bool greater_equal = carry != 0;
+        if (not greater_equal) {
+            greater_equal = true;
+            for (size_t i = N; i-- > 0;) {
+                if (value[i] != mod[i]) {
+                    greater_equal = value[i] > mod[i];
+                    break;
+                }
+            }
+        }
+        if (not greater_equal) return value;
+
+        Limbs result;
+        uint64_t borrow = 0;
+        unroll<N>([&](auto i) {
+            u128 d = static_cast<u128>(value[i]) - mod[i] - borrow;
+            result[i] = static_cast<uint64_t>(d);
+            borrow = static_cast<uint64_t>(d >> 64) & 1;
+        });
+        return result;
+    }
+#else
+    static constexpr bool available = false;
+#endif
+};
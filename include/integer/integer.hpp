@@ -1,19 +1,34 @@
 #pragma once
 
+#include <array>
+#include <bit>
 #include <cmath>
 #include <vector>
 #include <cstdint>
 #include <iomanip>
+#include <memory>
 #include <sstream>
+#include <variant>
 
 #include "spdlog/spdlog.h"
 
+#include "arena.hpp"
+#include "fixed_montgomery.hpp"
+#include "ntt.hpp"
+#include "rns.hpp"
+#include "small_vector.hpp"
+#include "task_pool.hpp"
+
 /**
  * @brief large integer data structure
  *
  * @tparam bit should be times of 32 / 64
+ * @tparam inline_chunks chunks stored inside the object, longer integers allocate on the heap. The default holds
+ *         the product of two 2048-bit integers (plus the spare chunks of `alloc_data`), so RSA-2048 does not allocate
+ * @tparam Allocator allocator of longer chunk buffers, by default the thread's `LimbArena` inside an `ArenaScope`
  */
-template<int bit, typename DataType , typename InterDataType, typename SignedInterDataType>
+template<int bit, typename DataType , typename InterDataType, typename SignedInterDataType, size_t inline_chunks = 4096 / bit + 4,
+         typename Allocator = ArenaAllocator<DataType>>
 struct Integer {
     explicit Integer() {
         current_length = 0;
@@ -33,9 +48,12 @@ struct Integer {
 
     ~Integer() = default;
 
+    /**
+     * only the significant chunks are copied, the spare capacity of other (e.g. a fused sum shifted in place) is not
+     */
     Integer(const Integer& other) : current_length(other.current_length) {
         alloc_data(current_length);
-        data = other.data;
+        std::copy(other.data.begin(), other.data.begin() + current_length, data.begin());
     }
 
     Integer& operator=(const Integer& other) {
@@ -82,11 +100,13 @@ struct Integer {
     }
 
     auto operator <=> (const Integer& other) const {
-        if (current_length != other.current_length) {
-            return current_length <=> other.current_length;
+        // leading zero chunks (e.g. a zero of length 1 against one of length 0) do not count
+        size_t length = significant_length(), other_length = other.significant_length();
+        if (length != other_length) {
+            return length <=> other_length;
         }
 
-        for (int i = current_length - 1; i >= 0; i--) {
+        for (int i = static_cast<int>(length) - 1; i >= 0; i--) {
             if (data[i] != other.data[i]) {
                 return data[i] <=> other.data[i];
             }
@@ -96,11 +116,12 @@ struct Integer {
     }
 
     bool operator == (const Integer& rhs) const {
-        if (current_length != rhs.current_length) {
+        size_t length = significant_length();
+        if (length != rhs.significant_length()) {
             return false;
         }
 
-        for (size_t i = 0; i < current_length; ++i) {
+        for (size_t i = 0; i < length; ++i) {
             if (data[i] != rhs.data[i]) {
                 return false;
             }
@@ -129,26 +150,170 @@ struct Integer {
         return *this - value;
     }
 
+    /**
+     * @brief operands with at least this many chunks on both sides are multiplied through NTT (64-bit chunks only)
+     */
+    static inline size_t ntt_threshold = 1536;
+
+    /**
+     * @brief products with at most this many chunks on one side are computed by long multiplication
+     */
+    static inline size_t karatsuba_threshold = 128;
+
     Integer operator * (const Integer& other) const {
+        if (std::min(current_length, other.current_length) >= ntt_threshold) {
+            return ntt_multiplication(other);
+        }
         auto result = karatsuba_multiplication(other);
         return result;
     }
 
+    /**
+     * @brief `parallel_multiply` only splits products with at least this many chunks on both sides
+     */
+    static inline size_t parallel_threshold = 256;
+
+    /**
+     * @brief same as `*`, the top Karatsuba levels run their sub-products as tasks on `TaskPool::global()`
+     *
+     * Opt-in for single very large products. Below the cutoff (depth or `parallel_threshold`) the sub-products
+     * are plain `*`, and without idle workers everything runs on the calling thread.
+     */
+    Integer parallel_multiply(const Integer& other) const {
+        size_t threads = TaskPool::global().size() + 1;
+        if (threads == 1) return *this * other;
+
+        // enough leaves to keep every thread busy: 3^depth >= 2 * threads
+        int depth = 0;
+        for (size_t leaves = 1; leaves < 2 * threads and depth < 4; leaves *= 3) depth++;
+        return parallel_multiply(other, depth);
+    }
+
     Integer operator * (const DataType other) const {
         return multiply_one_bit(other);
     }
 
+    /**
+     * @brief divisors and quotients with more chunks than this use Burnikel–Ziegler recursive division
+     */
+    static inline size_t burnikel_ziegler_threshold = 32;
+
     Integer operator / (const Integer& other) const {
         Integer reminder;
-        return knuth_division(other, reminder);
+        return division(other, reminder);
     }
 
     Integer operator % (const Integer& other) const {
         Integer reminder;
-        knuth_division(other, reminder);
+        division(other, reminder);
         return reminder;
     }
 
+    /**
+     * @brief quotient and remainder of one division
+     */
+    std::pair<Integer, Integer> divmod(const Integer& other) const {
+        std::pair<Integer, Integer> result;
+        result.first = division(other, result.second);
+        return result;
+    }
+
+    /**
+     * @brief lazy product a * b, the operand of the fused expressions below
+     *
+     * `lazy(a) * b` only records its operands. `c + lazy(a) * b`, `c - lazy(a) * b` (c >= a * b), optionally
+     * followed by `>> shift`, and `(lazy(a) * b).mod_2_pow(k)` are evaluated in one pass into the integer they
+     * are assigned to, and `+= lazy(a) * b` / `-= lazy(a) * b` into the left side, without a temporary for the
+     * product. The nodes only reference their operands: assign them in the same statement, never keep one in
+     * an `auto` variable.
+     */
+    struct Product {
+        const Integer& a;
+        const Integer& b;
+
+        /**
+         * @brief the low k bits of a * b (k a multiple of the chunk size), only the products below them are computed
+         */
+        [[nodiscard]] Integer mod_2_pow(size_t k) const {
+            return truncated_multiplication(a, b, k);
+        }
+
+        operator Integer() const {
+            return a * b;
+        }
+    };
+
+    struct Lazy {
+        const Integer& value;
+
+        Product operator * (const Integer& other) const {
+            return {value, other};
+        }
+    };
+
+    static Lazy lazy(const Integer& value) {
+        return {value};
+    }
+
+    /**
+     * @brief (addend +- a * b) >> shift
+     */
+    struct MultiplyAdd {
+        const Integer& addend;
+        Product product;
+        bool subtract = false;
+        size_t shift = 0;
+
+        MultiplyAdd operator >> (size_t bits) const {
+            MultiplyAdd shifted = *this;
+            shifted.shift += bits;
+            return shifted;
+        }
+    };
+
+    MultiplyAdd operator + (const Product& product) const {
+        return {*this, product, false};
+    }
+
+    MultiplyAdd operator - (const Product& product) const {
+        return {*this, product, true};
+    }
+
+    Integer(const MultiplyAdd& expression) {
+        evaluate(expression);
+    }
+
+    Integer& operator=(const MultiplyAdd& expression) {
+        evaluate(expression);
+        return *this;
+    }
+
+    Integer& operator+=(const Product& product) {
+        multiply_accumulate(product.a, product.b);
+        return *this;
+    }
+
+    /**
+     * @brief needs *this >= a * b
+     */
+    Integer& operator-=(const Product& product) {
+        multiply_subtract(product.a, product.b);
+        return *this;
+    }
+
+    Integer& operator+=(const Integer& other) {
+        add_inplace(other);
+        return *this;
+    }
+
+    /**
+     * @brief needs *this >= other
+     */
+    Integer& operator-=(const Integer& other) {
+        subtract_inplace(other);
+        return *this;
+    }
+
     DataType operator % (int other) const {
         DataType reminder;
         divide_one_bit(other, reminder);
@@ -165,23 +330,29 @@ struct Integer {
         return data[0] == other;
     }
 
-    Integer& operator>>=(int shift) {
-        if (shift == 0) return *this;
-
-        if (shift > bit)
-            throw std::runtime_error("shift value greater than chunk bit");
-        int bit_shift = shift % bit;
-        int bit_shift_inv = bit - bit_shift;
-
+    /**
+     * @brief shift right by any number of bits, in place
+     */
+    Integer& operator>>=(size_t shift) {
+        if (shift == 0 || current_length == 0) return *this;
+
+        size_t chunk_shift = shift / bit;
+        size_t bit_shift = shift % bit;
+        if (chunk_shift >= current_length) {
+            data[0] = 0;
+            current_length = 1;
+            return *this;
+        }
 
-        if (bit_shift > 0) {
-            DataType carry = 0;
-            for (int i = static_cast<int>(current_length) - 1; i >= 0; --i) {
-                DataType new_carry = (data[i] << bit_shift_inv) % radix();
-                data[i] = (data[i] >> bit_shift) | carry;
-                carry = new_carry;
+        size_t n = current_length - chunk_shift;
+        for (size_t i = 0; i < n; i++) {
+            DataType value = data[i + chunk_shift] >> bit_shift;
+            if (bit_shift > 0 && i + chunk_shift + 1 < current_length) {
+                value |= data[i + chunk_shift + 1] << (bit - bit_shift);
             }
+            data[i] = value;
         }
+        current_length = n;
 
         // Trim any leading zero chunks
         while (current_length > 1 && data[current_length - 1] == 0) {
@@ -191,6 +362,40 @@ struct Integer {
         return *this;
     }
 
+    Integer operator>>(size_t shift) const {
+        Integer result = *this;
+        result >>= shift;
+        return result;
+    }
+
+    /**
+     * @brief shift left by any number of bits
+     */
+    Integer operator<<(size_t shift) const {
+        if (current_length == 0) return *this;
+
+        size_t chunk_shift = shift / bit;
+        size_t bit_shift = shift % bit;
+        Integer result;
+        size_t n = current_length + chunk_shift + 1;
+        result.alloc_data(n);
+        result.current_length = n;
+
+        for (size_t i = 0; i < current_length; i++) {
+            result.data[i + chunk_shift] |= data[i] << bit_shift;
+            if (bit_shift > 0) {
+                result.data[i + chunk_shift + 1] = data[i] >> (bit - bit_shift);
+            }
+        }
+        result.remove_leading_zero();
+        return result;
+    }
+
+    Integer& operator<<=(size_t shift) {
+        *this = *this << shift;
+        return *this;
+    }
+
     template <typename T> int high_bit(T x) const {
         auto ux = std::make_unsigned_t<T>(x);
         int lb = -1, rb = std::numeric_limits<decltype(ux)>::digits;
@@ -218,24 +423,44 @@ struct Integer {
             throw std::runtime_error("data empty in bit_test");
         }
 
-        if (b == 0) {
-            int tmp = data[0] & 1;
-            return tmp;
+        if (b / bit >= current_length) {
+            return 0;
+        }
+
+        return static_cast<int>((data[b / bit] >> (b % bit)) & 1);
+    }
+
+    /**
+     * @brief bits [pos, pos + width) as a number, bits past the top are zero
+     *
+     * Reads at most two chunks, so exponent windows can be scanned in either direction without
+     * shifting a copy of the exponent.
+     *
+     * @param width 1 to bit
+     */
+    [[nodiscard]] DataType get_bits(size_t pos, size_t width) const {
+        size_t index = pos / bit;
+        size_t offset = pos % bit;
+        if (index >= current_length) {
+            return 0;
         }
 
-        return data[b / 4] & (1 << (b - (b / 4) * 4 - 1));
+        DataType value = data[index] >> offset;
+        if (offset + width > bit && index + 1 < current_length) {
+            value |= data[index + 1] << (bit - offset);
+        }
+        return width == bit ? value : value & ((static_cast<DataType>(1) << width) - 1);
     }
 
     void bit_set(size_t b) {
         if (data.empty()) {
             throw std::runtime_error("data empty in bit_set");
         }
-        if (b == 0) {
-            data[0] |= 1;
-            return;
+        if (b / bit >= current_length) {
+            throw std::runtime_error("bit index out of range in bit_set");
         }
 
-        data[b / 4] |= (1 << (b - (b / 4) * 4 - 1));
+        data[b / bit] |= static_cast<DataType>(1) << (b % bit);
     }
 
     Integer zero() const {
@@ -286,6 +511,77 @@ struct Integer {
         }
     }
 
+    /**
+     * @brief hash of the value, leading zero chunks do not count
+     */
+    [[nodiscard]] size_t hash() const {
+        uint64_t result = 0xcbf29ce484222325ULL;
+        for (size_t i = 0; i < significant_length(); i++) {
+            result = (result ^ static_cast<uint64_t>(data[i])) * 0x100000001b3ULL;
+            result ^= result >> 32;
+        }
+        return static_cast<size_t>(result);
+    }
+
+    /**
+     * @brief random integer of exactly `bits` bits (the top one set), chunks taken straight from generator
+     * @tparam Generator uniform random bit generator with 64-bit results, e.g. `Random::local()`
+     */
+    template<typename Generator>
+    static Integer random(size_t bits, Generator& generator) {
+        Integer result;
+        size_t n = (bits + bit - 1) / bit;
+        result.alloc_data(std::max<size_t>(n, 1));
+        result.current_length = std::max<size_t>(n, 1);
+        if (bits == 0) return result;
+
+        for (size_t i = 0; i < n; i++) {
+            result.data[i] = static_cast<DataType>(generator());
+        }
+        size_t top = (bits - 1) % bit;
+        if (top + 1 < bit) {
+            result.data[n - 1] &= (static_cast<DataType>(1) << (top + 1)) - 1;
+        }
+        result.data[n - 1] |= static_cast<DataType>(1) << top;
+        return result;
+    }
+
+    /**
+     * @brief load an unsigned big-endian byte string
+     * @param bytes
+     * @param length
+     */
+    void from_bytes(const uint8_t* bytes, size_t length) {
+        constexpr size_t bytes_per_chunk = bit / 8;
+        current_length = (length + bytes_per_chunk - 1) / bytes_per_chunk;
+        alloc_data(current_length);
+
+        for (size_t i = 0; i < length; i++) {
+            data[i / bytes_per_chunk] |= static_cast<DataType>(bytes[length - 1 - i]) << (8 * (i % bytes_per_chunk));
+        }
+
+        while (current_length > 0 && data[current_length - 1] == 0) current_length--;
+    }
+
+    /**
+     * @brief store as an unsigned big-endian byte string, left padded with zeros
+     * @param bytes output buffer
+     * @param length size of the output buffer, must be large enough to hold the value
+     */
+    void to_bytes(uint8_t* bytes, size_t length) const {
+        constexpr size_t bytes_per_chunk = bit / 8;
+        int top = current_length > 0 ? msb() : 0;
+        if (top > 0 && (static_cast<size_t>(top) + 7) / 8 > length) {
+            throw std::runtime_error("output buffer too small in to_bytes");
+        }
+
+        for (size_t i = 0; i < length; i++) {
+            size_t chunk = i / bytes_per_chunk;
+            DataType value = chunk < current_length ? data[chunk] : 0;
+            bytes[length - 1 - i] = static_cast<uint8_t>(value >> (8 * (i % bytes_per_chunk)));
+        }
+    }
+
     [[nodiscard]] std::string to_string() const {
         std::stringstream ss;
 
@@ -301,32 +597,529 @@ struct Integer {
         return ss.str();
     }
 
+    [[nodiscard]] size_t significant_length() const {
+        size_t length = current_length;
+        while (length > 0 and data[length - 1] == 0) length--;
+        return length;
+    }
+
+    [[nodiscard]] bool is_zero() const {
+        for (size_t i = 0; i < current_length; i++) {
+            if (data[i] != 0) return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief precomputed parameters for Montgomery arithmetic modulo an odd integer
+     *
+     * R = 2^r with r = bit * (chunk count of mod). Values passed to and returned by the arithmetic
+     * methods are in Montgomery form (x * R mod mod) and fully reduced.
+     */
+    struct MontgomeryContext {
+        explicit MontgomeryContext(const Integer& t_mod) : mod(t_mod) {
+            if (not mod.bit_test(0)) {
+                throw std::runtime_error("montgomery context needs an odd modulus");
+            }
+            r = mod.current_length * bit;
+            R = Integer{1}.left_shift_chunk(mod.current_length);
+            mod_inverse = mod.inverse_mod_2_pow(r);
+            negative_inverse = R - mod_inverse;
+            one = montgomery_transformation(Integer(1), mod, r);
+        }
+
+        [[nodiscard]] Integer to_montgomery(const Integer& x) const {
+            return montgomery_transformation(x, mod, r);
+        }
+
+        [[nodiscard]] Integer from_montgomery(const Integer& x) const {
+            return montgomery_reduce(x, r, mod, negative_inverse);
+        }
+
+        [[nodiscard]] Integer multiply(const Integer& a, const Integer& b) const {
+            return montgomery_multiplication(a, b, mod, negative_inverse, r);
+        }
+
+        [[nodiscard]] Integer add(const Integer& a, const Integer& b) const {
+            Integer sum = a + b;
+            if (sum >= mod) {
+                sum -= mod;
+            }
+            return sum;
+        }
+
+        [[nodiscard]] Integer subtract(const Integer& a, const Integer& b) const {
+            if (a >= b) {
+                return a - b;
+            }
+            Integer difference = a + mod;
+            difference -= b;
+            return difference;
+        }
+
+        /**
+         * @brief a^exp, a and the result in Montgomery form
+         *
+         * Left-to-right fixed window over `get_bits`, the window grows with the exponent so that short
+         * public exponents do not pay for a table.
+         */
+        [[nodiscard]] Integer pow(const Integer& a, const Integer& exp) const {
+            if (exp.current_length == 0 || exp.is_zero()) return one;
+
+            size_t bits = exp.msb();
+            size_t width = bits > 512 ? 5 : bits > 128 ? 4 : bits > 24 ? 3 : 1;
+
+            // table[i] = a^i, 2^width entries from the limb arena instead of a fixed array on the stack
+            using TableAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Integer>;
+            std::vector<Integer, TableAllocator> table(size_t{1} << width);
+            table[0] = one;
+            table[1] = a;
+            for (size_t i = 2; i < (size_t{1} << width); i++) {
+                table[i] = multiply(table[i - 1], a);
+            }
+
+            Integer result = one;
+            bool leading = true;
+            for (size_t pos = (bits + width - 1) / width * width; pos > 0;) {
+                pos -= width;
+                auto window = exp.get_bits(pos, width);
+                if (not leading) {
+                    for (size_t i = 0; i < width; i++) {
+                        result = multiply(result, result);
+                    }
+                }
+                if (window != 0) {
+                    result = leading ? table[window] : multiply(result, table[window]);
+                    leading = false;
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief a^exp for an exponent of at most 64 bits, square-and-multiply without a table
+         */
+        [[nodiscard]] Integer pow_small(const Integer& a, uint64_t exp) const {
+            if (exp == 0) return one;
+
+            Integer result = a;
+            for (int i = std::bit_width(exp) - 2; i >= 0; i--) {
+                result = multiply(result, result);
+                if ((exp >> i) & 1) {
+                    result = multiply(result, a);
+                }
+            }
+            return result;
+        }
+
+        /**
+         * @brief 2^exp in Montgomery form
+         *
+         * Left-to-right binary exponentiation where the multiplication by the base is a doubling,
+         * i.e. a one bit shift and a conditional subtraction, so only the squarings are full products.
+         */
+        [[nodiscard]] Integer pow_2(const Integer& exp) const {
+            Integer result = one;
+            if (exp.is_zero()) return result;
+
+            for (int i = exp.msb() - 1; i >= 0; i--) {
+                result = multiply(result, result);
+                if (exp.bit_test(i)) {
+                    result = add(result, result);
+                }
+            }
+            return result;
+        }
+
+        Integer mod;
+        Integer mod_inverse;
+        /**
+         * -mod^(-1) mod R
+         */
+        Integer negative_inverse;
+        Integer R;
+        Integer one;
+        uint64_t r = 0;
+    };
+
+    /**
+     * @brief residue modulo the odd modulus of a `MontgomeryContext`, kept in Montgomery form
+     *
+     * Converted once on construction and once by `to_integer`, the operators in between are
+     * Montgomery products and modular additions, so chains of them never divide. The context must
+     * outlive the value, both operands of an operator must share it.
+     */
+    struct MontgomeryInt {
+        MontgomeryInt(const MontgomeryContext& context, const Integer& x)
+                : context(&context), value(context.to_montgomery(x)) {}
+
+        /**
+         * @param montgomery_value already in Montgomery form and reduced
+         */
+        static MontgomeryInt from_montgomery_form(const MontgomeryContext& context, Integer montgomery_value) {
+            return MontgomeryInt(context, std::move(montgomery_value), 0);
+        }
+
+        static MontgomeryInt one(const MontgomeryContext& context) {
+            return from_montgomery_form(context, context.one);
+        }
+
+        [[nodiscard]] Integer to_integer() const {
+            return context->from_montgomery(value);
+        }
+
+        [[nodiscard]] const Integer& montgomery_form() const {
+            return value;
+        }
+
+        MontgomeryInt operator*(const MontgomeryInt& other) const {
+            return from_montgomery_form(*context, context->multiply(value, other.value));
+        }
+
+        MontgomeryInt operator+(const MontgomeryInt& other) const {
+            return from_montgomery_form(*context, context->add(value, other.value));
+        }
+
+        MontgomeryInt operator-(const MontgomeryInt& other) const {
+            return from_montgomery_form(*context, context->subtract(value, other.value));
+        }
+
+        MontgomeryInt operator-() const {
+            return from_montgomery_form(*context, context->subtract(Integer(0), value));
+        }
+
+        MontgomeryInt& operator*=(const MontgomeryInt& other) {
+            value = context->multiply(value, other.value);
+            return *this;
+        }
+
+        MontgomeryInt& operator+=(const MontgomeryInt& other) {
+            value = context->add(value, other.value);
+            return *this;
+        }
+
+        MontgomeryInt& operator-=(const MontgomeryInt& other) {
+            value = context->subtract(value, other.value);
+            return *this;
+        }
+
+        [[nodiscard]] MontgomeryInt pow(const Integer& exp) const {
+            return from_montgomery_form(*context, context->pow(value, exp));
+        }
+
+        [[nodiscard]] MontgomeryInt square() const {
+            return from_montgomery_form(*context, context->multiply(value, value));
+        }
+
+        /**
+         * @brief both forms are fully reduced, so equal residues have equal Montgomery forms
+         */
+        bool operator==(const MontgomeryInt& other) const {
+            return value == other.value;
+        }
+
+    private:
+        MontgomeryInt(const MontgomeryContext& context, Integer montgomery_value, int)
+                : context(&context), value(std::move(montgomery_value)) {}
+
+        const MontgomeryContext* context;
+        Integer value;
+    };
+
     static Integer fast_odd_exp_mod(const Integer& base, const Integer& exp, const Integer& mod) {
         if (not mod.bit_test(0)) {
             throw std::runtime_error("this only for computing exponential of odd numbers");
         }
 
-        DataType r = mod.current_length * bit;
-        Integer R = Integer{1}.left_shift_chunk(mod.current_length);
-        Integer mod_inverse = mod.inverse_mod_2_pow(r);
+        MontgomeryContext context(mod);
+        return MontgomeryInt(context, base).pow(exp).to_integer();
+    }
+
+    /**
+     * @brief 2^exp mod an odd modulus, see MontgomeryContext::pow_2
+     */
+    static Integer fast_odd_exp_mod_base_2(const Integer& exp, const Integer& mod) {
+        MontgomeryContext context(mod);
+        return context.from_montgomery(context.pow_2(exp));
+    }
+
+    /**
+     * @brief base^exp mod an odd modulus of exactly N chunks, through the unrolled `FixedMontgomery<N>` kernels
+     *
+     * Falls back to `fast_odd_exp_mod` for other modulus sizes and for chunks other than 64-bit.
+     */
+    template<size_t N>
+    static Integer fixed_odd_exp_mod(const Integer& base, const Integer& exp, const Integer& mod) {
+        if constexpr (bit == 64 and FixedMontgomery<N>::available) {
+            if (mod.significant_length() == N and mod.bit_test(0)) {
+                FixedMontgomery<N> kernel(to_limbs<N>(mod), to_limbs<N>(Integer{1}.left_shift_chunk(2 * N) % mod));
+                auto x = kernel.to_montgomery(to_limbs<N>(base >= mod ? base % mod : base));
+                return from_limbs<N>(kernel.from_montgomery(kernel.pow(x, reinterpret_cast<const uint64_t*>(exp.data.data()), exp.current_length)));
+            }
+        }
+        return fast_odd_exp_mod(base, exp, mod);
+    }
+
+    /**
+     * @brief base^exp mod one fixed odd modulus, everything that only depends on the modulus computed once
+     *
+     * Moduli of 16 / 32 / 48 / 64 chunks keep an unrolled `FixedMontgomery` kernel (64-bit chunks only), others
+     * a `MontgomeryContext`. Exponents of at most 64 bits, i.e. public RSA exponents, run a plain left-to-right
+     * square-and-multiply chain, 16 squarings and one multiplication for 65537.
+     *
+     * Meant to be kept with a key, so build it outside of any `ArenaScope` or in a `HeapScope`.
+     */
+    struct ExpModContext {
+        explicit ExpModContext(const Integer& t_mod) : mod(t_mod), kernel(make_kernel(t_mod)) {}
+
+        [[nodiscard]] Integer pow(const Integer& base, const Integer& exp) const {
+            Integer reduced = base >= mod ? base % mod : base;
+            return std::visit([&](const auto& k) { return pow_with(k, reduced, exp); }, kernel);
+        }
+
+        /**
+         * @brief limb count of the fixed-size kernel in use, 0 for the generic Montgomery context
+         */
+        [[nodiscard]] size_t fixed_limbs() const {
+            constexpr size_t sizes[] = {0, 16, 32, 48, 64};
+            return sizes[kernel.index()];
+        }
+
+        Integer mod;
+
+    private:
+        using Kernel = std::variant<MontgomeryContext, FixedMontgomery<16>, FixedMontgomery<32>, FixedMontgomery<48>, FixedMontgomery<64>>;
+
+        static Kernel make_kernel(const Integer& mod) {
+            if constexpr (bit == 64 and FixedMontgomery<16>::available) {
+                if (mod.bit_test(0)) {
+                    switch (mod.significant_length()) {
+                        case 16: return fixed_kernel<16>(mod);
+                        case 32: return fixed_kernel<32>(mod);
+                        case 48: return fixed_kernel<48>(mod);
+                        case 64: return fixed_kernel<64>(mod);
+                        default: break;
+                    }
+                }
+            }
+            return Kernel(std::in_place_type<MontgomeryContext>, mod);
+        }
+
+        template<size_t N>
+        static Kernel fixed_kernel(const Integer& mod) {
+            return Kernel(std::in_place_type<FixedMontgomery<N>>, to_limbs<N>(mod), to_limbs<N>(Integer{1}.left_shift_chunk(2 * N) % mod));
+        }
+
+        static Integer pow_with(const MontgomeryContext& context, const Integer& base, const Integer& exp) {
+            Integer x = context.to_montgomery(base);
+            return context.from_montgomery(exp.significant_length() * bit <= 64 ? context.pow_small(x, exp.low_64()) : context.pow(x, exp));
+        }
+
+        template<size_t N>
+        static Integer pow_with(const FixedMontgomery<N>& kernel, const Integer& base, const Integer& exp) {
+            if constexpr (bit == 64 and FixedMontgomery<N>::available) {
+                auto x = kernel.to_montgomery(to_limbs<N>(base));
+                auto result = exp.significant_length() * bit <= 64
+                        ? kernel.pow_small(x, exp.low_64())
+                        : kernel.pow(x, reinterpret_cast<const uint64_t*>(exp.data.data()), exp.current_length);
+                return from_limbs<N>(kernel.from_montgomery(result));
+            } else {
+                throw std::logic_error("fixed Montgomery kernel without 64-bit chunks");
+            }
+        }
+
+        Kernel kernel;
+    };
+
+#if defined(__SIZEOF_INT128__)
+    /**
+     * @brief experimental exponentiation modulo an odd integer in a residue number system, see `ResidueNumberSystem`
+     *
+     * Every product is a set of independent 32-bit channel products plus two base extensions of k x k words, so
+     * the work can be split across SIMD lanes or cores per channel, where the limb Montgomery product has a carry
+     * chain through every chunk. The bases are the largest primes below 2^32 that do not divide the modulus.
+     */
+    struct RnsContext {
+        explicit RnsContext(const Integer& t_mod) : mod(t_mod), system(make_system(t_mod)) {
+            const auto& moduli = system.channels;
+            size_t k = system.k;
+
+            M = Integer(1);
+            for (size_t i = 0; i < k; i++) {
+                M = M.multiply_one_bit(static_cast<DataType>(moduli[i].mod));
+            }
+            M_prime = Integer(1);
+            for (size_t j = 0; j < k; j++) {
+                Integer cofactor(1);
+                for (size_t l = 0; l < k; l++) {
+                    if (l != j) cofactor = cofactor.multiply_one_bit(static_cast<DataType>(moduli[k + l].mod));
+                }
+                cofactors.push_back(std::move(cofactor));
+                M_prime = M_prime.multiply_one_bit(static_cast<DataType>(moduli[k + j].mod));
+            }
+            one = residues(M % mod);
+        }
+
+        /**
+         * @brief base^exp mod mod, same fixed window as `MontgomeryContext::pow`
+         */
+        [[nodiscard]] Integer pow(const Integer& base, const Integer& exp) const {
+            size_t size = system.size();
+            std::vector<uint32_t> result = one, scratch(size);
+
+            if (not (exp.current_length == 0 || exp.is_zero())) {
+                size_t bits = exp.msb();
+                size_t width = bits > 512 ? 5 : bits > 128 ? 4 : bits > 24 ? 3 : 1;
+
+                // table[i] = base^i M mod mod, flat
+                Integer reduced = base >= mod ? base % mod : base;
+                std::vector<uint32_t> table(size << width);
+                std::copy(one.begin(), one.end(), table.begin());
+                auto x = residues(reduced * M % mod);
+                std::copy(x.begin(), x.end(), table.begin() + size);
+                for (size_t i = 2; i < (size_t{1} << width); i++) {
+                    system.multiply(&table[(i - 1) * size], x.data(), &table[i * size], scratch.data());
+                }
+
+                bool leading = true;
+                for (size_t pos = (bits + width - 1) / width * width; pos > 0;) {
+                    pos -= width;
+                    auto window = exp.get_bits(pos, width);
+                    if (not leading) {
+                        for (size_t i = 0; i < width; i++) {
+                            system.multiply(result.data(), result.data(), result.data(), scratch.data());
+                        }
+                    }
+                    if (window != 0) {
+                        if (leading) {
+                            std::copy(table.begin() + window * size, table.begin() + (window + 1) * size, result.begin());
+                        } else {
+                            system.multiply(result.data(), &table[window * size], result.data(), scratch.data());
+                        }
+                        leading = false;
+                    }
+                }
+            }
+
+            // out of the Montgomery form: a product with plain 1 leaves r < M' exactly on B'
+            std::vector<uint32_t> plain_one(size, 1);
+            system.multiply(result.data(), plain_one.data(), result.data(), scratch.data());
+            return from_residues(result) % mod;
+        }
+
+        Integer mod;
 
-        Integer result = montgomery_transformation(Integer(1), mod, r);
-        Integer a = montgomery_transformation(base, mod, r);
+    private:
+        static ResidueNumberSystem make_system(const Integer& mod) {
+            if (not mod.bit_test(0)) {
+                throw std::runtime_error("rns context needs an odd modulus");
+            }
+            // M, M' > 2^(31 k) >= 2 c^2 mod with c = k + 2, enough for chaining and the exact base extension
+            size_t bits = mod.msb(), k = 1;
+            while (31 * k < bits + 2 * std::bit_width(k + 2) + 1) k++;
+
+            std::vector<uint32_t> moduli, n_residues;
+            for (uint32_t prime: ResidueNumberSystem::primes()) {
+                if (moduli.size() == 2 * k) break;
+                uint32_t residue = residue_of(mod, prime);
+                if (residue == 0) continue;
+                moduli.push_back(prime);
+                n_residues.push_back(residue);
+            }
+            if (moduli.size() != 2 * k) {
+                throw std::invalid_argument("modulus too large for the rns context");
+            }
+            return {moduli, n_residues};
+        }
 
-        Integer exp_prime = exp;
+        static uint32_t residue_of(const Integer& x, uint64_t prime) {
+            uint64_t r = 0;
+            for (size_t i = x.current_length; i-- > 0;) {
+                for (int shift = bit - 32; shift >= 0; shift -= 32) {
+                    r = ((r << 32) | static_cast<uint32_t>(x.data[i] >> shift)) % prime;
+                }
+            }
+            return static_cast<uint32_t>(r);
+        }
 
-        while (exp_prime > 0) {
-            if (exp_prime.bit_test(0)) {
-                result = montgomery_multiplication(result, a, mod, mod_inverse, R, r);
+        [[nodiscard]] std::vector<uint32_t> residues(const Integer& x) const {
+            std::vector<uint32_t> result;
+            for (const auto& channel: system.channels) {
+                result.push_back(residue_of(x, channel.mod));
             }
-            exp_prime >>= 1;
-            a = montgomery_multiplication(a, a, mod, mod_inverse, R, r);
+            return result;
         }
 
-        return montgomery_reduce(result, R, r, mod, mod_inverse);
+        /**
+         * @brief the value below M' of the residues on B', by CRT
+         */
+        [[nodiscard]] Integer from_residues(const std::vector<uint32_t>& x) const {
+            size_t k = system.k;
+            Integer sum(0);
+            for (size_t j = 0; j < k; j++) {
+                const auto& channel = system.channels[k + j];
+                uint32_t xi = channel.multiply(x[k + j], system.crt_inverse[j]);
+                sum += cofactors[j].multiply_one_bit(static_cast<DataType>(xi));
+            }
+            return sum % M_prime;
+        }
+
+        ResidueNumberSystem system;
+        Integer M;
+        Integer M_prime;
+        /**
+         * M' / m'_j
+         */
+        std::vector<Integer> cofactors;
+        /**
+         * M mod mod on both bases, 1 in Montgomery form
+         */
+        std::vector<uint32_t> one;
+    };
+#endif
+
+    /**
+     * @brief base^exp mod an odd modulus through `RnsContext`, the same signature as `fast_odd_exp_mod`
+     *
+     * Falls back to `fast_odd_exp_mod` without a 128-bit integer type (`ResidueNumberSystem::available`).
+     */
+    static Integer rns_odd_exp_mod(const Integer& base, const Integer& exp, const Integer& mod) {
+#if defined(__SIZEOF_INT128__)
+        return RnsContext(mod).pow(base, exp);
+#else
+        return fast_odd_exp_mod(base, exp, mod);
+#endif
     }
 
 private:
+    template<size_t N>
+    static std::array<uint64_t, N> to_limbs(const Integer& x) {
+        std::array<uint64_t, N> limbs{};
+        std::copy(x.data.begin(), x.data.begin() + std::min(x.current_length, N), limbs.begin());
+        return limbs;
+    }
+
+    template<size_t N>
+    static Integer from_limbs(const std::array<uint64_t, N>& limbs) {
+        Integer result;
+        result.alloc_data(N);
+        result.current_length = N;
+        std::copy(limbs.begin(), limbs.end(), result.data.begin());
+        result.remove_leading_zero();
+        return result;
+    }
+
+    /**
+     * @brief the value modulo 2^64
+     */
+    [[nodiscard]] uint64_t low_64() const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < current_length and i * bit < 64; i++) {
+            value |= static_cast<uint64_t>(data[i]) << (i * bit);
+        }
+        return value;
+    }
+
     Integer add_one_bit(const DataType other) const {
         Integer result;
         size_t n = current_length + 1;
@@ -411,9 +1204,10 @@ private:
         for (size_t i = 0; i < n; i++) {
             DataType a = i < current_length ? data[i] : 0;
             DataType b = i < other.current_length ? other.data[i]: 0;
-            DataType sum = a + b + carry;
+            DataType partial = a + b;
+            DataType sum = partial + carry;
+            carry = (partial < a || sum < partial) ? 1 : 0;
             result.data[i] = sum;
-            carry = sum >= b ? 0 : 1;
         }
 
         result.current_length = n;
@@ -437,9 +1231,9 @@ private:
 
         DataType borrow = 0;
         for (size_t i = 0; i < current_length; ++i) {
-            DataType subtrahend = (i < other.current_length ? other.data[i] : 0) + borrow;
-            DataType difference = data[i] - subtrahend;
-            borrow = difference > data[i] ? 1 : 0;
+            DataType subtrahend = i < other.current_length ? other.data[i] : 0;
+            DataType difference = data[i] - subtrahend - borrow;
+            borrow = (data[i] < subtrahend || (data[i] == subtrahend && borrow)) ? 1 : 0;
             result.data[i] = static_cast<DataType>(difference);
         }
 
@@ -452,10 +1246,10 @@ private:
     void subtract_inplace(const Integer& other) {
         DataType borrow = 0;
         for (size_t i = 0; i < current_length; ++i) {
-            DataType subtrahend = other.data[i] + borrow;
-            DataType difference = data[i] - subtrahend;
+            DataType subtrahend = i < other.current_length ? other.data[i] : 0;
+            DataType difference = data[i] - subtrahend - borrow;
 
-            borrow = difference > data[i] ? 1 : 0;
+            borrow = (data[i] < subtrahend || (data[i] == subtrahend && borrow)) ? 1 : 0;
 
             data[i] = static_cast<DataType>(difference);
         }
@@ -463,6 +1257,146 @@ private:
         remove_leading_zero();
     }
 
+    /**
+     * @brief `resize` to n chunks keeping the value, the new chunks zero
+     */
+    void extend(size_t n) {
+        if (data.size() < n + 2) data.resize(n + 2);
+        std::fill(data.begin() + current_length, data.begin() + std::max(n, current_length), 0);
+        current_length = std::max(n, current_length);
+    }
+
+    void add_inplace(const Integer& other) {
+        size_t n = other.current_length;
+        extend(std::max(current_length, n) + 1);
+
+        DataType carry = 0;
+        size_t i = 0;
+        for (; i < n; i++) {
+            DataType partial = data[i] + other.data[i];
+            DataType sum = partial + carry;
+            carry = (partial < other.data[i] || sum < partial) ? 1 : 0;
+            data[i] = sum;
+        }
+        for (; carry and i < current_length; i++) {
+            carry = ++data[i] == 0 ? 1 : 0;
+        }
+        remove_leading_zero();
+    }
+
+    /**
+     * @brief *this += a * b, schoolbook rows straight into this below the Karatsuba threshold
+     */
+    void multiply_accumulate(const Integer& a, const Integer& b) {
+        if (a.current_length == 0 or b.current_length == 0) return;
+        if (this == &a or this == &b or std::min(a.current_length, b.current_length) > karatsuba_threshold) {
+            add_inplace(a * b);
+            return;
+        }
+
+        extend(std::max(current_length, a.current_length + b.current_length) + 1);
+        for (size_t j = 0; j < b.current_length; j++) {
+            DataType carry = 0;
+            for (size_t i = 0; i < a.current_length; i++) {
+                InterDataType prod = static_cast<InterDataType>(a.data[i]) * b.data[j] + data[i + j] + carry;
+                data[i + j] = static_cast<DataType>(prod);
+                carry = static_cast<DataType>(prod >> bit);
+            }
+            for (size_t k = a.current_length + j; carry; k++) {
+                DataType sum = data[k] + carry;
+                carry = sum < carry ? 1 : 0;
+                data[k] = sum;
+            }
+        }
+        remove_leading_zero();
+    }
+
+    /**
+     * @brief *this -= a * b for *this >= a * b, the rows subtract like the multiply-subtract step of Knuth division
+     */
+    void multiply_subtract(const Integer& a, const Integer& b) {
+        // leading zero limbs of a or b would index past the end of *this
+        size_t a_length = a.significant_length(), b_length = b.significant_length();
+        if (a_length == 0 or b_length == 0) return;
+        if (this == &a or this == &b or std::min(a_length, b_length) > karatsuba_threshold) {
+            subtract_inplace(a * b);
+            return;
+        }
+
+        for (size_t j = 0; j < b_length; j++) {
+            // product high part plus borrow, at most radix - 1
+            DataType carry = 0;
+            for (size_t i = 0; i < a_length; i++) {
+                InterDataType prod = static_cast<InterDataType>(a.data[i]) * b.data[j] + carry;
+                DataType low = static_cast<DataType>(prod);
+                carry = static_cast<DataType>(prod >> bit) + (data[i + j] < low ? 1 : 0);
+                data[i + j] -= low;
+            }
+            for (size_t k = a_length + j; carry and k < current_length; k++) {
+                DataType borrow = data[k] < carry ? 1 : 0;
+                data[k] -= carry;
+                carry = borrow;
+            }
+        }
+        remove_leading_zero();
+    }
+
+    /**
+     * @brief (a * b) mod 2^k, skipping every partial product at or above chunk k / bit
+     */
+    static Integer truncated_multiplication(const Integer& a, const Integer& b, size_t k) {
+        if (std::min(a.current_length, b.current_length) > karatsuba_threshold) {
+            return (a * b).mod_2_pow(k);
+        }
+        if (k % bit != 0) {
+            throw std::runtime_error("only support module 2 ^ {n * bit} for efficiency");
+        }
+
+        size_t chunks = k / bit;
+        Integer result;
+        result.alloc_data(chunks);
+        result.current_length = chunks;
+        for (size_t j = 0; j < std::min(b.current_length, chunks); j++) {
+            DataType carry = 0;
+            size_t end = std::min(a.current_length, chunks - j);
+            for (size_t i = 0; i < end; i++) {
+                InterDataType prod = static_cast<InterDataType>(a.data[i]) * b.data[j] + result.data[i + j] + carry;
+                result.data[i + j] = static_cast<DataType>(prod);
+                carry = static_cast<DataType>(prod >> bit);
+            }
+            if (end + j < chunks) {
+                result.data[end + j] = carry;
+            }
+        }
+        result.remove_leading_zero();
+        return result;
+    }
+
+    /**
+     * @brief assign a `MultiplyAdd`, in place when this is its addend
+     */
+    void evaluate(const MultiplyAdd& expression) {
+        const Product& product = expression.product;
+        if (this == &product.a or this == &product.b) {
+            *this = Integer(expression);
+            return;
+        }
+        if (this != &expression.addend) {
+            // one buffer that already fits the sum
+            const Integer& addend = expression.addend;
+            size_t n = expression.subtract ? addend.current_length : std::max(addend.current_length, product.a.current_length + product.b.current_length) + 1;
+            alloc_data(n);
+            std::copy(addend.data.begin(), addend.data.begin() + addend.current_length, data.begin());
+            current_length = addend.current_length;
+        }
+        if (expression.subtract) {
+            multiply_subtract(product.a, product.b);
+        } else {
+            multiply_accumulate(product.a, product.b);
+        }
+        *this >>= expression.shift;
+    }
+
     Integer long_multiplication(const Integer& other) const {
         Integer result;
 
@@ -493,9 +1427,19 @@ private:
         return result;
     }
 
-    Integer karatsuba_multiplication(const Integer& other) const {
+    Integer parallel_multiply(const Integer& other, int depth) const {
+        if (depth == 0 or std::min(current_length, other.current_length) < parallel_threshold) {
+            return *this * other;
+        }
+        return karatsuba_multiplication(other, depth);
+    }
+
+    /**
+     * @param parallel_depth number of top levels whose sub-products run as tasks on `TaskPool::global()`
+     */
+    Integer karatsuba_multiplication(const Integer& other, int parallel_depth = 0) const {
         // Base case: use long multiplication for small numbers
-        if (current_length <= 128 || other.current_length <= 128) {
+        if (current_length <= karatsuba_threshold || other.current_length <= karatsuba_threshold) {
             return long_multiplication(other);
         }
         size_t n = std::max(current_length, other.current_length);
@@ -505,26 +1449,43 @@ private:
         const Integer & v2 = res ? *this: other;
         // Split `this` into high and low parts
         Integer low1, high1;
-        low1.data = std::vector<DataType>(v1.data.begin(), v1.data.begin() + half);
-        high1.data = std::vector<DataType>(v1.data.begin() + half, v1.data.begin() + v1.current_length);
+        low1.data = Storage(v1.data.begin(), v1.data.begin() + half);
+        high1.data = Storage(v1.data.begin() + half, v1.data.begin() + v1.current_length);
         low1.current_length = half;
         high1.current_length = v1.current_length - half;
         Integer result;
         if (v2.current_length <= half) {
-            Integer z0 = std::move(high1.karatsuba_multiplication(v2));
-            Integer z1 = std::move(low1.karatsuba_multiplication(v2));
+            Integer z0, z1;
+            if (parallel_depth > 0) {
+                TaskPool::global().invoke(
+                        [&] { z0 = high1.parallel_multiply(v2, parallel_depth - 1); },
+                        [&] { z1 = low1.parallel_multiply(v2, parallel_depth - 1); });
+            } else {
+                z0 = std::move(high1.karatsuba_multiplication(v2));
+                z1 = std::move(low1.karatsuba_multiplication(v2));
+            }
             result = std::move(z0.left_shift_chunk(half) + z1);
         } else {
             // Split `other` into high and low parts
             Integer low2, high2;
-            low2.data = std::vector<DataType>(v2.data.begin(), v2.data.begin() + half);
-            high2.data = std::vector<DataType>(v2.data.begin() + half, v2.data.begin() + v2.current_length);
+            low2.data = Storage(v2.data.begin(), v2.data.begin() + half);
+            high2.data = Storage(v2.data.begin() + half, v2.data.begin() + v2.current_length);
             low2.current_length = low2.data.size();
             high2.current_length = high2.data.size();
             // Recursively calculate three products
-            Integer z0 = std::move(low1.karatsuba_multiplication(low2));
-            Integer z2 = std::move(high1.karatsuba_multiplication(high2));
-            Integer z1 = std::move((low1 + high1).karatsuba_multiplication(low2 + high2) - z0 - z2);
+            Integer z0, z1, z2;
+            if (parallel_depth > 0) {
+                Integer sum1 = low1 + high1, sum2 = low2 + high2;
+                TaskPool::global().invoke(
+                        [&] { z1 = sum1.parallel_multiply(sum2, parallel_depth - 1); },
+                        [&] { z0 = low1.parallel_multiply(low2, parallel_depth - 1); },
+                        [&] { z2 = high1.parallel_multiply(high2, parallel_depth - 1); });
+            } else {
+                z0 = std::move(low1.karatsuba_multiplication(low2));
+                z2 = std::move(high1.karatsuba_multiplication(high2));
+                z1 = std::move((low1 + high1).karatsuba_multiplication(low2 + high2));
+            }
+            z1 = std::move(z1 - z0 - z2);
             result = std::move(z0 + z1.left_shift_chunk(half) + z2.left_shift_chunk(half * 2));
         }
         // Update result length
@@ -535,6 +1496,21 @@ private:
         return result;
     }
 
+    Integer ntt_multiplication(const Integer& other) const {
+        if constexpr (bit == 64 and NumberTheoreticTransform::available) {
+            Integer result;
+            result.current_length = current_length + other.current_length;
+            result.alloc_data(result.current_length);
+            NumberTheoreticTransform::multiply(reinterpret_cast<const uint64_t*>(data.data()), current_length,
+                                               reinterpret_cast<const uint64_t*>(other.data.data()), other.current_length,
+                                               reinterpret_cast<uint64_t*>(result.data.data()));
+            result.remove_leading_zero();
+            return result;
+        } else {
+            return karatsuba_multiplication(other);
+        }
+    }
+
     void remove_leading_zero() {
         while(current_length > 1 && data[current_length - 1] == 0) current_length --;
     }
@@ -561,8 +1537,9 @@ private:
         int chunks = k / bit;
         Integer result;
         result.alloc_data(chunks);
-        std::copy(data.begin(), data.begin() + chunks, result.data.begin());
+        std::copy(data.begin(), data.begin() + std::min<size_t>(chunks, current_length), result.data.begin());
         result.current_length = chunks;
+        result.remove_leading_zero();
         return result;
     }
 
@@ -572,26 +1549,37 @@ private:
      * @return
      */
     Integer inverse_mod_2_pow(size_t k) const {
-        Integer result{1};
-        Integer base = *this;
-        for (int i = 0; i < k - 1; i ++) {
-            result = (result * base).mod_2_pow(k);
-            base = (base * base).mod_2_pow(k);
+        // Newton (Hensel) iteration x <- x * (2 - a * x) doubles the number of correct low bits,
+        // first on the lowest chunk, then on the whole integer
+        DataType x = data[0];
+        for (int correct = 3; correct < bit; correct *= 2) {
+            x *= 2 - data[0] * x;
+        }
+
+        Integer a = mod_2_pow(k);
+        Integer two = Integer{1}.left_shift_chunk(k / bit) + 2;
+        Integer result{x};
+        for (size_t correct = bit; correct < k; correct *= 2) {
+            Integer t = (a * result).mod_2_pow(k);
+            result = (result * (two - t)).mod_2_pow(k);
         }
         return result;
     }
 
-    static Integer montgomery_multiplication(const Integer& a, const Integer& b, const Integer& mod, const Integer& mod_inverse, const Integer& R, uint64_t r) {
+    static Integer montgomery_multiplication(const Integer& a, const Integer& b, const Integer& mod, const Integer& negative_inverse, uint64_t r) {
         Integer c = a * b;
-        return montgomery_reduce(c, R, r, mod, mod_inverse);
+        return montgomery_reduce(c, r, mod, negative_inverse);
     }
 
-    static Integer montgomery_reduce(const Integer& x, const Integer& R, uint64_t r, const Integer& mod, const Integer& mod_inverse) {
-        Integer q = (x.mod_2_pow(r) * (R - mod_inverse)).mod_2_pow(r);
-        Integer a = x + q * mod;
-        a = a.right_shift_chunk(r / bit);
+    /**
+     * @brief x * R^(-1) mod mod, with the fused expressions: q = x * (-mod^(-1)) mod R only computes the low half,
+     * x + q * mod accumulates into the result, which is then shifted and reduced in place
+     */
+    static Integer montgomery_reduce(const Integer& x, uint64_t r, const Integer& mod, const Integer& negative_inverse) {
+        Integer q = (lazy(x) * negative_inverse).mod_2_pow(r);
+        Integer a = (x + lazy(q) * mod) >> r;
         if (a >= mod) {
-            a = a - mod;
+            a -= mod;
         }
         return a;
     }
@@ -610,81 +1598,227 @@ private:
         return result;
     }
 
+    /**
+     * @brief Knuth's Algorithm D (TAOCP 4.3.1), in place on one scratch buffer
+     *
+     * Both operands are normalized by a bit shift so the divisor's top bit is set, every quotient chunk is
+     * estimated from the top two chunks of the remainder and corrected at most twice, and the multiply-subtract
+     * works directly on the chunks of the normalized dividend, whose low chunks end up as the remainder.
+     */
     Integer knuth_division(const Integer& t_divisor, Integer& t_reminder) const {
+        size_t m = t_divisor.significant_length();
+        if (m == 0) {
+            throw std::runtime_error("division by zero");
+        }
         if (*this < t_divisor) {
             t_reminder = *this + 0;
             return zero();
         }
+        if (m == 1) {
+            DataType reminder;
+            Integer result = divide_one_bit(t_divisor.data[0], reminder);
+            t_reminder = Integer(reminder);
+            return result;
+        }
 
-        Integer dividend = *this;
-        Integer divisor = t_divisor;
-        Integer result;
-        DataType v = radix() / (divisor.data[divisor.current_length - 1] + 1);
-        dividend = dividend * v;
-        divisor = divisor * v;
+        size_t n = significant_length();
+        int shift = std::countl_zero(t_divisor.data[m - 1]);
+
+        // normalized dividend u (n + 1 chunks) and divisor v (m chunks), each fits the inline storage up to
+        // the sizes of RSA-2048
+        Storage dividend, divisor;
+        dividend.resize(n + 1);
+        divisor.resize(m);
+        DataType* u = dividend.data();
+        DataType* v = divisor.data();
+        u[n] = shift_left_chunks(data.data(), n, shift, u);
+        shift_left_chunks(t_divisor.data.data(), m, shift, v);
 
-        int n = dividend.current_length;
-        int m = divisor.current_length;
-        result.alloc_data(n - m);
+        Integer result;
+        result.alloc_data(n - m + 1);
+        result.current_length = n - m + 1;
 
-        DataType highest  = divisor.data[divisor.current_length - 1];
+        for (size_t j = n - m + 1; j-- > 0;) {
+            // q_hat from the top two chunks, corrected with the third so it is at most one too large
+            InterDataType numerator = static_cast<InterDataType>(u[j + m]) << bit | u[j + m - 1];
+            InterDataType q_hat = numerator / v[m - 1];
+            InterDataType r_hat = numerator % v[m - 1];
+            while (q_hat >= radix() or q_hat * v[m - 2] > (r_hat << bit | u[j + m - 2])) {
+                q_hat--;
+                r_hat += v[m - 1];
+                if (r_hat >= radix()) break;
+            }
 
-        if (m == n) {
-            result.alloc_data(1);
-            if (dividend >= divisor) {
-                result.current_length = 1;
-                result.data[0] = 1;
-            } else {
-                result.current_length = 0;
-                result.data[0] = 0;
+            // u[j .. j + m] -= q_hat * v
+            InterDataType carry = 0;
+            DataType borrow = 0;
+            for (size_t i = 0; i < m; i++) {
+                InterDataType product = q_hat * v[i] + carry;
+                carry = product >> bit;
+                InterDataType difference = static_cast<InterDataType>(u[i + j]) - static_cast<DataType>(product) - borrow;
+                u[i + j] = static_cast<DataType>(difference);
+                borrow = (difference >> bit) != 0;
             }
-            t_reminder = *this - result * t_divisor;
-            return result;
+            InterDataType difference = static_cast<InterDataType>(u[j + m]) - carry - borrow;
+            u[j + m] = static_cast<DataType>(difference);
+
+            if ((difference >> bit) != 0) {
+                // q_hat was one too large, add v back (the carry out cancels the borrow)
+                q_hat--;
+                DataType add_carry = 0;
+                for (size_t i = 0; i < m; i++) {
+                    InterDataType sum = static_cast<InterDataType>(u[i + j]) + v[i] + add_carry;
+                    u[i + j] = static_cast<DataType>(sum);
+                    add_carry = static_cast<DataType>(sum >> bit);
+                }
+                u[j + m] += add_carry;
+            }
+            result.data[j] = static_cast<DataType>(q_hat);
         }
+        result.remove_leading_zero();
 
-        if (dividend.data[n - 1] == 0) {
-            spdlog::warn("wrong");
+        // the low m chunks of u are the remainder, shifted back
+        t_reminder.alloc_data(m);
+        t_reminder.current_length = m;
+        for (size_t i = 0; i < m; i++) {
+            t_reminder.data[i] = shift == 0 ? u[i] : u[i] >> shift | static_cast<DataType>(u[i + 1] << (bit - shift));
         }
+        t_reminder.remove_leading_zero();
+        return result;
+    }
 
-        for (int i = n - m - 1; i >= 0; i--) {
-            Integer reminder = dividend.get_chunks(i, 1 + m);
+    /**
+     * @brief output[0 .. length) = input << shift for 0 <= shift < bit
+     * @return the chunk shifted out at the top
+     */
+    static DataType shift_left_chunks(const DataType* input, size_t length, int shift, DataType* output) {
+        if (shift == 0) {
+            std::copy(input, input + length, output);
+            return 0;
+        }
+        DataType carry = 0;
+        for (size_t i = 0; i < length; i++) {
+            DataType chunk = input[i];
+            output[i] = chunk << shift | carry;
+            carry = chunk >> (bit - shift);
+        }
+        return carry;
+    }
 
-            // quotient estimation
-            SignedInterDataType q = (static_cast<InterDataType>(reminder.data[m]) * radix() + reminder.data[m - 1]) / static_cast<InterDataType>(highest) - 2;
-            q = std::max(q, static_cast<SignedInterDataType>(0));
+    Integer division(const Integer& divisor, Integer& reminder) const {
+        if (divisor.current_length > burnikel_ziegler_threshold and
+            current_length >= divisor.current_length + burnikel_ziegler_threshold) {
+            return burnikel_ziegler_division(divisor, reminder);
+        }
+        return knuth_division(divisor, reminder);
+    }
 
-            // remove leading zeros
-            reminder.remove_leading_zero();
-            if (q < radix()) {
-                reminder.subtract_inplace(divisor.multiply_one_bit(q));
-            } else {
-                DataType q_low = q % radix();
-                DataType q_high = q >> bit;
-                reminder.subtract_inplace(divisor.multiply_one_bit(q_low) + divisor.left_shift_chunk(1).multiply_one_bit(q_high));
-            }
+    /**
+     * @brief chunks [start, start + length) as an integer, chunks past the end read as zero
+     */
+    Integer slice_chunks(size_t start, size_t length) const {
+        Integer result;
+        result.alloc_data(length);
+        result.current_length = length;
+        if (start < current_length) {
+            size_t end = std::min(current_length, start + length);
+            std::copy(data.begin() + start, data.begin() + end, result.data.begin());
+        }
+        result.remove_leading_zero();
+        return result;
+    }
 
-            int t = 0;
-            while (reminder >= divisor) {
-                q++;
-                t++;
-                if (t > 3) {
-                    throw std::runtime_error("knuth division failed");
-                }
-                reminder.subtract_inplace(divisor);
+    /**
+     * @brief Burnikel–Ziegler recursive division
+     *
+     * The divisor is normalized like in `knuth_division` and padded with low zero chunks to n = j * 2^k chunks,
+     * j <= burnikel_ziegler_threshold. The dividend is then divided block by block (n chunks each) with the
+     * recursive 2n / 1n step, whose multiplications go through Karatsuba / NTT.
+     */
+    Integer burnikel_ziegler_division(const Integer& t_divisor, Integer& t_reminder) const {
+        size_t s = t_divisor.current_length;
+        size_t k = 0;
+        while (((s + (size_t{1} << k) - 1) >> k) > burnikel_ziegler_threshold) k++;
+        size_t n = ((s + (size_t{1} << k) - 1) >> k) << k;
+        size_t shift = n - s;
+
+        DataType v = radix() / (static_cast<InterDataType>(t_divisor.data[s - 1]) + 1);
+        Integer divisor = t_divisor.multiply_one_bit(v).left_shift_chunk(shift);
+        Integer dividend = multiply_one_bit(v).left_shift_chunk(shift);
+
+        size_t t = dividend.current_length / n + 1;
+        if (t < 2) {
+            return knuth_division(t_divisor, t_reminder);
+        }
+
+        Integer result;
+        result.alloc_data(t * n);
+        result.current_length = t * n;
+
+        // the highest block is shorter than n chunks, so it is below the divisor
+        Integer z = dividend.slice_chunks((t - 2) * n, 2 * n);
+        Integer reminder;
+        for (size_t i = t - 1; i-- > 0;) {
+            Integer q = divide_2n_1n(z, divisor, n, reminder);
+            std::copy(q.data.begin(), q.data.begin() + q.current_length, result.data.begin() + i * n);
+            if (i > 0) {
+                z = reminder.left_shift_chunk(n) + dividend.slice_chunks((i - 1) * n, n);
+                z.remove_leading_zero();
             }
+        }
+        result.remove_leading_zero();
 
-            std::copy(reminder.data.begin(), reminder.data.begin() + reminder.current_length, dividend.data.begin() + i);
-            std::fill(dividend.data.begin() + i + reminder.current_length, dividend.data.begin() + i + m + 1, 0);
+        DataType unused;
+        t_reminder = reminder.slice_chunks(shift, n).divide_one_bit(v, unused);
+        return result;
+    }
 
-            result.data[i] = q % radix();
-            result.data[i + 1] += q >> bit;
+    /**
+     * @brief a / b for a < b * radix^n, b of n chunks with the highest bit set
+     */
+    static Integer divide_2n_1n(const Integer& a, const Integer& b, size_t n, Integer& reminder) {
+        if (n % 2 == 1 or n <= burnikel_ziegler_threshold) {
+            return a.knuth_division(b, reminder);
         }
 
-        result.current_length = n - m + 1;
-        while(result.current_length >= 1 and result.data[result.current_length - 1] == 0) result.current_length--;
+        size_t half = n / 2;
+        Integer b1 = b.slice_chunks(half, half);
+        Integer b2 = b.slice_chunks(0, half);
 
-        t_reminder = *this - result * t_divisor;
-        return result;
+        Integer r1;
+        Integer q1 = divide_3n_2n(a.slice_chunks(2 * half, 2 * half), a.slice_chunks(half, half), b, b1, b2, half, r1);
+        Integer q2 = divide_3n_2n(r1, a.slice_chunks(0, half), b, b1, b2, half, reminder);
+        Integer q = q1.left_shift_chunk(half) + q2;
+        q.remove_leading_zero();
+        return q;
+    }
+
+    /**
+     * @brief [a12, a3] / [b1, b2] for chunk counts 2n, n / n, n and a12 < b * radix^n
+     */
+    static Integer divide_3n_2n(const Integer& a12, const Integer& a3, const Integer& b, const Integer& b1, const Integer& b2,
+                                size_t n, Integer& reminder) {
+        Integer q, r1;
+        if (a12.slice_chunks(n, n) < b1) {
+            q = divide_2n_1n(a12, b1, n, r1);
+        } else {
+            // a1 == b1, the quotient estimation is radix^n - 1
+            q.alloc_data(n);
+            q.current_length = n;
+            std::fill(q.data.begin(), q.data.begin() + n, ~DataType{0});
+            r1 = a12 - b1.left_shift_chunk(n) + b1;
+        }
+
+        // the estimation exceeds the quotient by at most 2
+        Integer d = q * b2;
+        reminder = r1.left_shift_chunk(n) + a3;
+        reminder.remove_leading_zero();
+        while (reminder < d) {
+            q = q - 1;
+            reminder = reminder + b;
+        }
+        reminder = reminder - d;
+        return q;
     }
 
     Integer long_division(const Integer& divisor, Integer& remainder) const {
@@ -743,7 +1877,9 @@ private:
         return std::pow(2, bit);
     }
 
-    std::vector<DataType> data;
+    using Storage = SmallVector<DataType, inline_chunks, Allocator>;
+
+    Storage data;
     size_t current_length = 0;
 
 
@@ -798,6 +1934,35 @@ struct SignedInteger{
         return result;
     }
 
+    /**
+     * @brief lazy signed product, see `Integer::lazy`; `c + lazy(a) * b` and `c - lazy(a) * b` run the fused
+     * unsigned multiply-add / multiply-subtract on the magnitudes
+     */
+    struct Product {
+        const SignedInteger& a;
+        const SignedInteger& b;
+    };
+
+    struct Lazy {
+        const SignedInteger& value;
+
+        Product operator * (const SignedInteger& other) const {
+            return {value, other};
+        }
+    };
+
+    static Lazy lazy(const SignedInteger& value) {
+        return {value};
+    }
+
+    SignedInteger operator + (const Product& product) const {
+        return multiply_add(product, false);
+    }
+
+    SignedInteger operator - (const Product& product) const {
+        return multiply_add(product, true);
+    }
+
     SignedInteger operator * (const SignedInteger& other) const {
         SignedInteger result;
         result.abs = abs * other.abs;
@@ -818,6 +1983,38 @@ struct SignedInteger{
         result.sign = sign;
         return result;
     }
+
+private:
+    SignedInteger multiply_add(const Product& product, bool subtract) const {
+        const auto& a = product.a.abs;
+        const auto& b = product.b.abs;
+        // sign of the term added to *this
+        bool term_sign = (product.a.sign == product.b.sign) != subtract;
+
+        SignedInteger result = *this;
+        if (a.is_zero() or b.is_zero()) {
+            return result;
+        }
+        if (result.abs.is_zero()) {
+            result.abs += UnsignedIntegerType::lazy(a) * b;
+            result.sign = term_sign;
+        } else if (sign == term_sign) {
+            result.abs += UnsignedIntegerType::lazy(a) * b;
+        } else if (static_cast<size_t>(abs.msb()) > static_cast<size_t>(a.msb()) + static_cast<size_t>(b.msb())) {
+            // |a * b| < 2^(msb(a) + msb(b)) <= |*this|
+            result.abs -= UnsignedIntegerType::lazy(a) * b;
+        } else {
+            UnsignedIntegerType term = a * b;
+            if (result.abs >= term) {
+                result.abs -= term;
+            } else {
+                term -= result.abs;
+                result.abs = std::move(term);
+                result.sign = term_sign;
+            }
+        }
+        return result;
+    }
 };
 
 #if defined(__GNUC__)
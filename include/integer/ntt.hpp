@@ -0,0 +1,185 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+/**
+ * @brief multiplication of huge integers through number theoretic transforms
+ *
+ * Operands are split into 32-bit pieces and convolved modulo two NTT friendly primes just below 2^62,
+ * the exact convolution is recovered by CRT (the coefficients are below n * 2^64 < p1 * p2) and the carries
+ * are propagated once. The modular arithmetic uses 64-bit Montgomery multiplication, so this is only
+ * available where the compiler provides a 128-bit integer.
+ */
+struct NumberTheoreticTransform {
+#if defined(__SIZEOF_INT128__)
+    static constexpr bool available = true;
+
+    /**
+     * @brief prime field Z/p with 2^k | p - 1, elements kept in Montgomery form (R = 2^64)
+     */
+    template<uint64_t Mod, uint64_t Generator>
+    struct Field {
+        static constexpr uint64_t mod = Mod;
+
+        static constexpr uint64_t negative_inverse() {
+            uint64_t x = Mod;
+            for (int i = 0; i < 6; i++) x *= 2 - Mod * x;
+            return ~x + 1;
+        }
+
+        static constexpr uint64_t neg_inv = negative_inverse();
+        static constexpr uint64_t r_mod = static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) % Mod);
+        static constexpr uint64_t r2_mod = static_cast<uint64_t>(static_cast<unsigned __int128>(r_mod) * r_mod % Mod);
+
+        static uint64_t reduce(unsigned __int128 t) {
+            uint64_t m = static_cast<uint64_t>(t) * neg_inv;
+            uint64_t u = static_cast<uint64_t>((t + static_cast<unsigned __int128>(m) * Mod) >> 64);
+            return u >= Mod ? u - Mod : u;
+        }
+
+        static uint64_t multiply(uint64_t a, uint64_t b) {
+            return reduce(static_cast<unsigned __int128>(a) * b);
+        }
+
+        static uint64_t add(uint64_t a, uint64_t b) {
+            uint64_t s = a + b;
+            return s >= Mod ? s - Mod : s;
+        }
+
+        static uint64_t subtract(uint64_t a, uint64_t b) {
+            return a >= b ? a - b : a + Mod - b;
+        }
+
+        static uint64_t to_montgomery(uint64_t a) {
+            return multiply(a % Mod, r2_mod);
+        }
+
+        static uint64_t from_montgomery(uint64_t a) {
+            return reduce(a);
+        }
+
+        static uint64_t pow(uint64_t a, uint64_t exp) {
+            uint64_t result = r_mod;
+            while (exp > 0) {
+                if (exp & 1) result = multiply(result, a);
+                a = multiply(a, a);
+                exp >>= 1;
+            }
+            return result;
+        }
+
+        /**
+         * @brief in-place transform of a power of two length, Montgomery form in and out
+         */
+        static void transform(std::vector<uint64_t>& a, bool inverse) {
+            size_t n = a.size();
+
+            for (size_t i = 1, j = 0; i < n; i++) {
+                size_t bit = n >> 1;
+                for (; j & bit; bit >>= 1) j ^= bit;
+                j ^= bit;
+                if (i < j) std::swap(a[i], a[j]);
+            }
+
+            std::vector<uint64_t> roots(n / 2);
+            for (size_t len = 2; len <= n; len <<= 1) {
+                uint64_t w = pow(to_montgomery(Generator), (Mod - 1) / len);
+                if (inverse) w = pow(w, Mod - 2);
+
+                size_t half = len / 2;
+                roots[0] = r_mod;
+                for (size_t i = 1; i < half; i++) roots[i] = multiply(roots[i - 1], w);
+
+                for (size_t i = 0; i < n; i += len) {
+                    for (size_t j = 0; j < half; j++) {
+                        uint64_t u = a[i + j];
+                        uint64_t v = multiply(a[i + j + half], roots[j]);
+                        a[i + j] = add(u, v);
+                        a[i + j + half] = subtract(u, v);
+                    }
+                }
+            }
+
+            if (inverse) {
+                uint64_t n_inv = pow(to_montgomery(n), Mod - 2);
+                for (auto& x: a) x = multiply(x, n_inv);
+            }
+        }
+
+        /**
+         * @brief cyclic convolution of two piece arrays modulo Mod, normal form output of length n
+         */
+        static std::vector<uint64_t> convolution(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b, size_t n) {
+            std::vector<uint64_t> fa(n, 0), fb(n, 0);
+            for (size_t i = 0; i < a.size(); i++) fa[i] = to_montgomery(a[i]);
+            for (size_t i = 0; i < b.size(); i++) fb[i] = to_montgomery(b[i]);
+
+            transform(fa, false);
+            transform(fb, false);
+            for (size_t i = 0; i < n; i++) fa[i] = multiply(fa[i], fb[i]);
+            transform(fa, true);
+
+            for (auto& x: fa) x = from_montgomery(x);
+            return fa;
+        }
+    };
+
+    // 29 * 2^57 + 1 and 65535 * 2^46 + 1, transform lengths up to 2^46
+    using Field1 = Field<4179340454199820289ULL, 3>;
+    using Field2 = Field<4611615649683210241ULL, 11>;
+
+    /**
+     * @brief result = a * b for little-endian 64-bit limb arrays, result must hold a_len + b_len limbs
+     */
+    static void multiply(const uint64_t* a, size_t a_len, const uint64_t* b, size_t b_len, uint64_t* result) {
+        auto split = [](const uint64_t* x, size_t len) {
+            std::vector<uint32_t> pieces(2 * len);
+            for (size_t i = 0; i < len; i++) {
+                pieces[2 * i] = static_cast<uint32_t>(x[i]);
+                pieces[2 * i + 1] = static_cast<uint32_t>(x[i] >> 32);
+            }
+            return pieces;
+        };
+
+        std::vector<uint32_t> pa = split(a, a_len);
+        std::vector<uint32_t> pb = split(b, b_len);
+
+        size_t n = 1;
+        while (n < pa.size() + pb.size()) n <<= 1;
+
+        std::vector<uint64_t> c1 = Field1::convolution(pa, pb, n);
+        std::vector<uint64_t> c2 = Field2::convolution(pa, pb, n);
+
+        // x = c1 + p1 * ((c2 - c1) * p1^{-1} mod p2)
+        constexpr uint64_t p1_mod_p2 = Field1::mod % Field2::mod;
+        const uint64_t p1_inv = Field2::pow(Field2::to_montgomery(p1_mod_p2), Field2::mod - 2);
+
+        unsigned __int128 carry = 0;
+        size_t pieces = 2 * (a_len + b_len);
+        for (size_t i = 0; i < pieces; i++) {
+            if (i < n) {
+                uint64_t diff = Field2::subtract(c2[i] % Field2::mod, c1[i] % Field2::mod);
+                uint64_t k = Field2::from_montgomery(Field2::multiply(Field2::to_montgomery(diff), p1_inv));
+                carry += static_cast<unsigned __int128>(k) * Field1::mod + c1[i];
+            }
+
+            auto piece = static_cast<uint32_t>(carry);
+            carry >>= 32;
+            if (i % 2 == 0) {
+                result[i / 2] = piece;
+            } else {
+                result[i / 2] |= static_cast<uint64_t>(piece) << 32;
+            }
+        }
+    }
+#else
+    static constexpr bool available = false;
+
+    static void multiply(const uint64_t*, size_t, const uint64_t*, size_t, uint64_t*) {
+        throw std::runtime_error("number theoretic transform needs 128-bit integer support");
+    }
+#endif
+};
@@ -1,5 +1,12 @@
 #pragma once
 
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
 #include <thread>
 #include "random.hpp"
 
@@ -17,17 +24,82 @@ inline void bit_set(BigInt& value, size_t b) {
     return value.bit_set(b);
 }
 
+enum class PrimalityTest {
+    /**
+     * random base Miller-Rabin, 2 - 27 rounds depending on the bit length
+     */
+    miller_rabin,
+    /**
+     * Baillie-PSW: base 2 Miller-Rabin and a strong Lucas test, plus `bpsw_extra_rounds` random base rounds
+     */
+    baillie_psw
+};
+
+/**
+ * @brief thrown by a prime search stopped through its `SearchLimits` before it found its primes
+ */
+struct SearchCancelled : std::runtime_error {
+    using std::runtime_error::runtime_error;
+};
+
+/**
+ * @brief counters of a running prime search, may be read from any thread
+ */
+struct SearchProgress {
+    std::atomic<size_t> candidates{0};
+    /**
+     * primes accepted into the set being searched; a prime rejected by the validator is not counted.
+     * `get_primes` counts them itself, callers of `get_prime` call `SearchLimits::count_prime`
+     */
+    std::atomic<size_t> primes_found{0};
+};
+
+/**
+ * @brief when a prime search gives up: stop_token triggered or deadline passed
+ *
+ * The search threads check both before every candidate, so a search stops within about one
+ * primality test.
+ */
+struct SearchLimits {
+    std::stop_token stop_token;
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    /**
+     * optional, updated by the search threads
+     */
+    SearchProgress* progress = nullptr;
+
+    [[nodiscard]] bool past_deadline() const {
+        return deadline != std::chrono::steady_clock::time_point::max() and std::chrono::steady_clock::now() >= deadline;
+    }
+
+    [[noreturn]] void throw_cancelled() const {
+        if (stop_token.stop_requested()) {
+            throw SearchCancelled("prime search cancelled");
+        }
+        throw SearchCancelled("prime search deadline exceeded");
+    }
+
+    void count_candidate() const {
+        if (progress != nullptr) progress->candidates.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void count_prime() const {
+        if (progress != nullptr) progress->primes_found.fetch_add(1, std::memory_order_relaxed);
+    }
+};
+
 template<typename IntegerType>
 struct PrimeGenerator {
     static inline std::vector<uint32_t> small_primes = {};
+    static inline std::once_flag small_primes_flag;
 
-    static int generate_random() {
-        static std::random_device rd;
-        static std::mt19937_64 gen(rd());
+    static inline PrimalityTest primality_test = PrimalityTest::baillie_psw;
+    static inline int bpsw_extra_rounds = 0;
 
+    static int generate_random() {
         std::uniform_int_distribution<int> dist(0, 32768);
 
-        return 2 + dist(gen);
+        return 2 + dist(Random::local());
     }
 
     static std::vector<uint32_t> generate_primes(int count) {
@@ -49,16 +121,22 @@ struct PrimeGenerator {
         return primes;
     }
 
-    static IntegerType mod_exp(IntegerType base, IntegerType exponent, const IntegerType& mod)  {
+    /**
+     * whether IntegerType brings Montgomery arithmetic (`Integer` does); other integer types, e.g. boost's
+     * cpp_int, test primality through `mod_exp`
+     */
+    static constexpr bool has_montgomery = requires { typename IntegerType::MontgomeryContext; };
+
+    static IntegerType mod_exp(IntegerType base, const IntegerType& exponent, const IntegerType& mod)  {
         IntegerType result{1};
+        if (not (exponent > 0)) return result;
         base = base % mod;
-        while (exponent > 0) {
-            if (bit_test(exponent, 0)) {
+        // msb is the bit count for Integer but the top bit index for boost, start at the larger one
+        for (int i = msb(exponent); i >= 0; --i) {
+            result = (result * result) % mod;
+            if (bit_test(exponent, i)) {
                 result = (result * base) % mod;
             }
-            exponent >>= 1;
-
-            base = (base * base) % mod;
         }
 
         return result;
@@ -73,27 +151,46 @@ struct PrimeGenerator {
         int s = 0;
 
         // Write value - 1 as d * 2^s by factoring out powers of 2 from d
-        while (bit_test(d, 0) == 0) {
-            d >>= 1;
+        while (bit_test(d, s) == 0) {
             ++s;
         }
+        d >>= s;
+
+        if constexpr (has_montgomery) {
+            // the witness loop stays in Montgomery form, only the base is converted
+            using MontgomeryInt = typename IntegerType::MontgomeryInt;
+            typename IntegerType::MontgomeryContext context(value);
+            const MontgomeryInt one = MontgomeryInt::one(context);
+            const MontgomeryInt minus_one = -one;
+            return miller_rabin_rounds(iterations, s, one, minus_one,
+                                       [&] { return MontgomeryInt(context, IntegerType{generate_random()}).pow(d); },
+                                       [](const MontgomeryInt& x) { return x.square(); });
+        } else {
+            const IntegerType one{1};
+            const IntegerType minus_one = value - 1;
+            return miller_rabin_rounds(iterations, s, one, minus_one,
+                                       [&] { return mod_exp(IntegerType{generate_random()}, d, value); },
+                                       [&](const IntegerType& x) { return (x * x) % value; });
+        }
+    }
 
+    /**
+     * @brief the witness rounds of `pass_miller_rabin` for value - 1 = d * 2^s, in any representation
+     * @param power a random base to the power d
+     * @param square x^2 mod value
+     */
+    template<typename Value, typename Power, typename Square>
+    static bool miller_rabin_rounds(int iterations, int s, const Value& one, const Value& minus_one, Power&& power, Square&& square) {
         // Perform the Miller-Rabin test with the specified number of iterations
         for (int i = 0; i < iterations; ++i) {
-            IntegerType a{generate_random()};
-            IntegerType x;
-            if constexpr (std::is_same_v<IntegerType, BigInt>) {
-                x = BigInt::fast_odd_exp_mod(a, d, value);
-            } else {
-                x = mod_exp(a, d, value);
-            }
+            Value x = power();
 
-            if (x == 1 || x == d) continue;
+            if (x == one || x == minus_one) continue;
 
             bool found = false;
             for (int r = 1; r < s; ++r) {
-                x = (x * x) % value;  // Square x mod value
-                if (x == value - 1) {
+                x = square(x);
+                if (x == minus_one) {
                     found = true;
                     break;
                 }
@@ -105,6 +202,173 @@ struct PrimeGenerator {
         return true;  // Likely prime if all iterations passed
     }
 
+    /**
+     * @brief Miller-Rabin test with the fixed base 2, using MontgomeryContext::pow_2
+     */
+    static bool pass_miller_rabin_base_2(const IntegerType& value) {
+        return pass_miller_rabin_base_2(value, typename IntegerType::MontgomeryContext(value));
+    }
+
+    template<typename Context>
+    static bool pass_miller_rabin_base_2(const IntegerType& value, const Context& context) {
+        IntegerType d = value - 1;
+        int s = 0;
+        while (bit_test(d, s) == 0) {
+            ++s;
+        }
+        d >>= s;
+
+        IntegerType minus_one = context.subtract(IntegerType(0), context.one);
+
+        IntegerType x = context.pow_2(d);
+        if (x == context.one || x == minus_one) return true;
+
+        for (int r = 1; r < s; ++r) {
+            x = context.multiply(x, x);
+            if (x == minus_one) return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief Jacobi symbol (a / n) for odd n > 0
+     */
+    static int jacobi(int64_t a, int64_t n) {
+        int result = 1;
+        a %= n;
+        if (a < 0) a += n;
+
+        while (a != 0) {
+            while (a % 2 == 0) {
+                a /= 2;
+                int64_t r = n % 8;
+                if (r == 3 || r == 5) result = -result;
+            }
+            std::swap(a, n);
+            if (a % 4 == 3 && n % 4 == 3) result = -result;
+            a %= n;
+        }
+        return n == 1 ? result : 0;
+    }
+
+    /**
+     * @brief Jacobi symbol (d / value) for a small odd d and a large odd value
+     */
+    static int jacobi(int64_t d, const IntegerType& value) {
+        int result = 1;
+        if (d < 0) {
+            d = -d;
+            // (-1 / value) = -1 iff value = 3 mod 4
+            if (value % 4 == 3) result = -result;
+        }
+        // quadratic reciprocity, both odd and positive
+        if (d % 4 == 3 && value % 4 == 3) result = -result;
+        return result * jacobi(static_cast<int64_t>(value % static_cast<int>(d)), d);
+    }
+
+    static bool is_square(const IntegerType& value) {
+        // Newton iteration for floor(sqrt(value)), starting above the root
+        IntegerType x(std::string("0x1") + std::string((msb(value) / 2 + 4) / 4, '0'));
+        while (true) {
+            IntegerType y = (x + value / x);
+            y >>= 1;
+            if (y >= x) break;
+            x = std::move(y);
+        }
+        return x * x == value;
+    }
+
+    /**
+     * @brief strong Lucas probable prime test with Selfridge's parameters (method A)
+     *
+     * D is the first of 5, -7, 9, -11, ... with (D / value) = -1, P = 1 and Q = (1 - D) / 4. With
+     * value + 1 = d * 2^s, value passes if U_d = 0 or V_{d * 2^r} = 0 for some 0 <= r < s. The Lucas
+     * sequences are evaluated in Montgomery form, halving is the same in both forms.
+     */
+    static bool pass_strong_lucas(const IntegerType& value) {
+        return pass_strong_lucas(value, typename IntegerType::MontgomeryContext(value));
+    }
+
+    template<typename Context>
+    static bool pass_strong_lucas(const IntegerType& value, const Context& context) {
+        int64_t D = 5;
+        while (true) {
+            int j = jacobi(D, value);
+            if (j == -1) break;
+            if (j == 0 && not (value == static_cast<int>(D < 0 ? -D : D))) return false;
+            if (D == 21 && is_square(value)) return false;
+            D = D > 0 ? -(D + 2) : -D + 2;
+        }
+        int64_t Q = (1 - D) / 4;
+
+        // D and Q are small, multiplying by them is a short chain of modular additions
+        auto multiply_small = [&](const IntegerType& x, int64_t c) {
+            IntegerType result(0);
+            for (int i = std::bit_width(static_cast<uint64_t>(c < 0 ? -c : c)) - 1; i >= 0; i--) {
+                result = context.add(result, result);
+                if (((c < 0 ? -c : c) >> i) & 1) {
+                    result = context.add(result, x);
+                }
+            }
+            return c < 0 ? context.subtract(IntegerType(0), result) : result;
+        };
+        auto half = [&](IntegerType x) {
+            if (bit_test(x, 0)) x = x + value;
+            x >>= 1;
+            return x;
+        };
+
+        IntegerType d = value + 1;
+        int s = 0;
+        while (bit_test(d, s) == 0) {
+            ++s;
+        }
+        d >>= s;
+
+        // k = 1
+        IntegerType U = context.one;
+        IntegerType V = context.one;
+        IntegerType Qk = multiply_small(context.one, Q);
+
+        for (int i = msb(d) - 2; i >= 0; i--) {
+            // k -> 2k
+            U = context.multiply(U, V);
+            V = context.subtract(context.multiply(V, V), context.add(Qk, Qk));
+            Qk = context.multiply(Qk, Qk);
+
+            if (bit_test(d, i)) {
+                // k -> k + 1 with P = 1
+                IntegerType next_U = half(context.add(U, V));
+                V = half(context.add(multiply_small(U, D), V));
+                U = std::move(next_U);
+                Qk = multiply_small(Qk, Q);
+            }
+        }
+
+        if (U.is_zero() || V.is_zero()) return true;
+
+        for (int r = 1; r < s; r++) {
+            V = context.subtract(context.multiply(V, V), context.add(Qk, Qk));
+            if (V.is_zero()) return true;
+            Qk = context.multiply(Qk, Qk);
+        }
+        return false;
+    }
+
+    /**
+     * @brief Baillie-PSW probable prime test, no known composite passes it
+     */
+    static bool pass_baillie_psw(const IntegerType& value, int extra_rounds) {
+        if (value < 2) return false;
+        if (value == 2 || value == 3) return true;
+        if (bit_test(value, 0) == 0) return false;
+
+        typename IntegerType::MontgomeryContext context(value);
+        if (not pass_miller_rabin_base_2(value, context)) return false;
+        if (not pass_strong_lucas(value, context)) return false;
+        return extra_rounds == 0 || pass_miller_rabin(value, extra_rounds);
+    }
+
     /**
      * @brief judge if a integer is prime
      *
@@ -114,6 +378,11 @@ struct PrimeGenerator {
      * @return
      */
     static bool is_prime(IntegerType& value) {
+        // temporaries of one primality test come from the thread's arena
+        return ArenaScope::run([&] { return is_prime_in_arena(value); });
+    }
+
+    static bool is_prime_in_arena(IntegerType& value) {
         int bit_length = msb(value);
 
         int try_time = 0;
@@ -138,6 +407,13 @@ struct PrimeGenerator {
                 return false;
         }
 
+        // Baillie-PSW needs the Montgomery context of `Integer`
+        if constexpr (std::is_same_v<IntegerType, BigInt>) {
+            if (primality_test == PrimalityTest::baillie_psw) {
+                return pass_baillie_psw(value, bpsw_extra_rounds);
+            }
+        }
+
         return pass_miller_rabin(value, try_time);
     }
 
@@ -145,13 +421,17 @@ struct PrimeGenerator {
         std::mutex lock;
         bool found = false;
         IntegerType value;
+        /**
+         * first exception of a search thread, rethrown by the caller
+         */
+        std::exception_ptr error;
     };
 
-    static void find_prime(IntegerType start_value, int step, std::stop_token stop_token, std::stop_source& stop_source, IntegerWithMutex* result) {
+    static void find_prime(IntegerType start_value, int step, std::stop_token stop_token, std::stop_source& stop_source, IntegerWithMutex* result, const SearchLimits* limits) {
         IntegerType value = start_value;
-        int try_num = 1;
-        while(not stop_token.stop_requested()) {
-            try {
+        try {
+            while (not stop_token.stop_requested() and not limits->past_deadline()) {
+                limits->count_candidate();
                 if (is_prime(value)) {
                     std::scoped_lock lock(result->lock);
                     result->found = true;
@@ -160,49 +440,194 @@ struct PrimeGenerator {
                     break;
                 }
                 value = value + step;
-                try_num++;
-            }
-            catch (std::exception& e) {
-                spdlog::error(e.what());
             }
         }
+        catch (...) {
+            std::scoped_lock lock(result->lock);
+            if (not result->error) result->error = std::current_exception();
+            stop_source.request_stop();
+        }
     }
 
     /**
      * @brief generate a prime integer with given bit count
      * @param bit_count
+     * @param limits stop / deadline of the search, `SearchCancelled` is thrown when they end it
+     * @param top_bits leading one bits of the search start, see `random_odd_integer`
      * @return
      */
-    static IntegerType get_prime(int bit_count) {
-        if (small_primes.empty())
-            small_primes = generate_primes(8192);
+    static IntegerType get_prime(int bit_count, const SearchLimits& limits = {}, int top_bits = 1) {
+        // get_prime may be entered from several threads at once (e.g. a background key pool)
+        std::call_once(small_primes_flag, [] { small_primes = generate_primes(8192); });
 
         IntegerWithMutex result;
-        uint32_t num_threads = std::thread::hardware_concurrency();
+        uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
         // spdlog::info("num_threads {}", num_threads);
         std::stop_source stop_source;
+        std::stop_callback cancel(limits.stop_token, [&] { stop_source.request_stop(); });
 
         std::vector<std::jthread> threads;
         for (uint32_t i = 0; i < num_threads; ++i) {
-            std::string num_str;
-            if constexpr (std::is_same_v<IntegerType, BigInt>) {
-                num_str = Random::generate_random_large_number<Random::DigitFormat::hex>(bit_count);
-            } else {
-                num_str = Random::generate_random_large_number<Random::DigitFormat::dec>(bit_count);
+            threads.emplace_back(find_prime, random_odd_integer(bit_count, top_bits), 2, stop_source.get_token(), std::ref(stop_source), &result, &limits);
+        }
+
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        if (result.error) std::rethrow_exception(result.error);
+        if (not result.found) limits.throw_cancelled();
+        return result.value;
+    }
+
+    /**
+     * @brief random odd integer with given hex digit count (decimal digits for non BigInt types)
+     * @param top_bits leading bits forced to one (BigInt only), so that a product of several such values
+     *        keeps the sum of their bit lengths
+     */
+    static IntegerType random_odd_integer(int digit_count, int top_bits = 1) {
+        IntegerType value;
+        if constexpr (std::is_same_v<IntegerType, BigInt>) {
+            // top hex digit 8 - f, i.e. exactly 4 * digit_count bits
+            value = BigInt::random(4 * digit_count, Random::local());
+            for (int i = 2; i <= std::min(top_bits, 4 * digit_count); i++) {
+                value.bit_set(4 * digit_count - i);
             }
-            IntegerType value(num_str);
+        } else {
+            value = IntegerType(Random::generate_random_large_number<Random::DigitFormat::dec>(digit_count));
+        }
+
+        if (not bit_test(value, 0)) {
+            bit_set(value, 0);
+        }
+        return value;
+    }
 
-            if (not bit_test(value, 0)) {
-                bit_set(value, 0);
+    /**
+     * @brief validation of a newly found prime against the primes accepted so far
+     */
+    using PrimeValidator = std::function<bool(const IntegerType&, const std::vector<IntegerType>&)>;
+
+    struct PrimeSetSearch {
+        std::mutex lock;
+        std::vector<int> digit_counts;
+        std::vector<IntegerType> primes;
+        std::vector<bool> filled;
+        size_t remaining = 0;
+        const PrimeValidator* validator = nullptr;
+        const SearchLimits* limits = nullptr;
+        int top_bits = 1;
+        std::exception_ptr error;
+
+        /**
+         * @return digit count of some still missing prime, spread over the threads by `hint`
+         */
+        int wanted_digit_count(size_t hint) {
+            std::scoped_lock guard(lock);
+            std::vector<int> wanted;
+            for (size_t i = 0; i < digit_counts.size(); i++) {
+                if (not filled[i]) wanted.push_back(digit_counts[i]);
             }
-            threads.emplace_back(find_prime, value, 2, stop_source.get_token(), std::ref(stop_source), &result);
+            return wanted.empty() ? 0 : wanted[hint % wanted.size()];
+        }
+
+        /**
+         * @return true when this prime completed the set
+         */
+        bool offer(const IntegerType& prime, int digit_count) {
+            std::scoped_lock guard(lock);
+            if (remaining == 0) return false;
+
+            std::vector<IntegerType> accepted;
+            for (size_t i = 0; i < primes.size(); i++) {
+                if (filled[i]) accepted.push_back(primes[i]);
+            }
+            if (not (*validator)(prime, accepted)) return false;
+
+            for (size_t i = 0; i < digit_counts.size(); i++) {
+                if (not filled[i] and digit_counts[i] == digit_count) {
+                    filled[i] = true;
+                    primes[i] = prime;
+                    limits->count_prime();
+                    return --remaining == 0;
+                }
+            }
+            return false;
+        }
+    };
+
+    static void find_prime_set(size_t thread_index, std::stop_token stop_token, std::stop_source& stop_source, PrimeSetSearch* search) {
+        size_t restarts = 0;
+        auto running = [&] { return not stop_token.stop_requested() and not search->limits->past_deadline(); };
+        try {
+            while (running()) {
+                int digit_count = search->wanted_digit_count(thread_index + restarts++);
+                if (digit_count == 0) break;
+
+                // every found prime (accepted or not) restarts from a fresh random point, so the primes
+                // of one set never come from the same neighbourhood
+                IntegerType value = random_odd_integer(digit_count, search->top_bits);
+                while (running()) {
+                    search->limits->count_candidate();
+                    if (is_prime(value)) {
+                        if (search->offer(value, digit_count)) {
+                            stop_source.request_stop();
+                        }
+                        break;
+                    }
+                    value = value + 2;
+                }
+            }
+        }
+        catch (...) {
+            std::scoped_lock guard(search->lock);
+            if (not search->error) search->error = std::current_exception();
+            stop_source.request_stop();
+        }
+    }
+
+    /**
+     * @brief search several primes at once with one shared pool of threads
+     *
+     * Every thread searches for any still missing prime. A found prime is checked by `validator`
+     * against the primes accepted so far; a rejected prime is dropped and the search simply goes on,
+     * instead of restarting the whole set.
+     *
+     * @param digit_counts hex digit count of each wanted prime
+     * @param validator
+     * @param limits stop / deadline of the search, `SearchCancelled` is thrown when they end it
+     * @param top_bits leading one bits of every search start, see `random_odd_integer`
+     * @return the primes, in the order of digit_counts
+     */
+    static std::vector<IntegerType> get_primes(const std::vector<int>& digit_counts, const PrimeValidator& validator,
+                                               const SearchLimits& limits = {}, int top_bits = 1) {
+        std::call_once(small_primes_flag, [] { small_primes = generate_primes(8192); });
+
+        PrimeSetSearch search;
+        search.digit_counts = digit_counts;
+        search.primes.resize(digit_counts.size());
+        search.filled.assign(digit_counts.size(), false);
+        search.remaining = digit_counts.size();
+        search.validator = &validator;
+        search.limits = &limits;
+        search.top_bits = top_bits;
+
+        uint32_t num_threads = std::max(1u, std::thread::hardware_concurrency());
+        std::stop_source stop_source;
+        std::stop_callback cancel(limits.stop_token, [&] { stop_source.request_stop(); });
+
+        std::vector<std::jthread> threads;
+        for (uint32_t i = 0; i < num_threads; ++i) {
+            threads.emplace_back(find_prime_set, i, stop_source.get_token(), std::ref(stop_source), &search);
         }
 
         for (auto& t : threads) {
             t.join();
         }
 
-        return result.value;
+        if (search.error) std::rethrow_exception(search.error);
+        if (search.remaining > 0) limits.throw_cancelled();
+        return search.primes;
     }
 
 };
\ No newline at end of file
@@ -1,23 +1,133 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <limits>
 #include <random>
 #include <string>
 
+/**
+ * @brief ChaCha20 keystream as a 64-bit random bit generator (256-bit key, 64-bit block counter, 64-bit stream)
+ */
+struct ChaCha20 {
+    using result_type = uint64_t;
+    using Key = std::array<uint32_t, 8>;
+
+    ChaCha20(const Key& key, uint64_t stream) {
+        input[0] = 0x61707865;
+        input[1] = 0x3320646e;
+        input[2] = 0x79622d32;
+        input[3] = 0x6b206574;
+        std::copy(key.begin(), key.end(), input.begin() + 4);
+        input[12] = 0;
+        input[13] = 0;
+        input[14] = static_cast<uint32_t>(stream);
+        input[15] = static_cast<uint32_t>(stream >> 32);
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (position == buffer.size()) {
+            refill();
+        }
+        return buffer[position++];
+    }
+
+private:
+    static constexpr uint32_t rotl(uint32_t x, int n) {
+        return (x << n) | (x >> (32 - n));
+    }
+
+    static void quarter_round(std::array<uint32_t, 16>& x, int a, int b, int c, int d) {
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 16);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 12);
+        x[a] += x[b]; x[d] = rotl(x[d] ^ x[a], 8);
+        x[c] += x[d]; x[b] = rotl(x[b] ^ x[c], 7);
+    }
+
+    /**
+     * @brief next 64-byte block of the keystream, read as little-endian 64-bit words
+     */
+    void refill() {
+        std::array<uint32_t, 16> x = input;
+        for (int i = 0; i < 10; i++) {
+            quarter_round(x, 0, 4, 8, 12);
+            quarter_round(x, 1, 5, 9, 13);
+            quarter_round(x, 2, 6, 10, 14);
+            quarter_round(x, 3, 7, 11, 15);
+            quarter_round(x, 0, 5, 10, 15);
+            quarter_round(x, 1, 6, 11, 12);
+            quarter_round(x, 2, 7, 8, 13);
+            quarter_round(x, 3, 4, 9, 14);
+        }
+        for (size_t i = 0; i < buffer.size(); i++) {
+            buffer[i] = static_cast<uint64_t>(x[2 * i] + input[2 * i]) |
+                        static_cast<uint64_t>(x[2 * i + 1] + input[2 * i + 1]) << 32;
+        }
+
+        if (++input[12] == 0) ++input[13];
+        position = 0;
+    }
+
+    std::array<uint32_t, 16> input;
+    std::array<uint64_t, 8> buffer{};
+    size_t position = buffer.size();
+};
+
 struct Random {
     enum class DigitFormat {
         dec, hex
     };
 
+    /**
+     * @brief the calling thread's generator, keyed from std::random_device unless `seed` was called
+     */
+    static ChaCha20& local() {
+        thread_local ChaCha20 generator = make_generator();
+        thread_local uint64_t generation = current_generation.load(std::memory_order_acquire);
+
+        uint64_t current = current_generation.load(std::memory_order_acquire);
+        if (generation != current) {
+            generator = make_generator();
+            generation = current;
+        }
+        return generator;
+    }
+
+    /**
+     * @brief deterministic mode: every thread generator is rekeyed from value
+     *
+     * The threads get streams 0, 1, 2, ... in the order they first draw after this call, so a run is
+     * reproducible when the draws happen in the same order (e.g. key generation on one search thread).
+     * Call it while no other thread is drawing.
+     */
+    static void seed(uint64_t value) {
+        seed_value.store(value, std::memory_order_relaxed);
+        seeded.store(true, std::memory_order_relaxed);
+        next_stream.store(0, std::memory_order_relaxed);
+        current_generation.fetch_add(1, std::memory_order_release);
+    }
+
+    /**
+     * @brief back to keys from std::random_device
+     */
+    static void seed_from_device() {
+        seeded.store(false, std::memory_order_relaxed);
+        current_generation.fetch_add(1, std::memory_order_release);
+    }
+
     template<DigitFormat Format = DigitFormat::hex>
     static std::string generate_random_large_number(size_t digits) {
+        auto& gen = local();
         if constexpr (Format == DigitFormat::hex) {
             static const char hex_chars[] = "0123456789abcdef";
             std::string result;
             result.reserve(digits);
 
-            // Random number generator
-            std::random_device rd;
-            std::mt19937 gen(rd());
             std::uniform_int_distribution<int> dist(0, 15); // Range for hex characters
             std::uniform_int_distribution<int> dist_non_zero(8, 15); // Range for hex characters
 
@@ -30,8 +140,6 @@ struct Random {
             }
             return "0x" + result;
         } else {
-            std::random_device rd;
-            std::mt19937_64 gen(rd());
             std::uniform_int_distribution<int> dis(0, 9);
 
             std::string number;
@@ -46,4 +154,33 @@ struct Random {
             return number;
         }
     }
-};
\ No newline at end of file
+
+private:
+    static ChaCha20 make_generator() {
+        ChaCha20::Key key;
+        if (seeded.load(std::memory_order_relaxed)) {
+            // splitmix64 expands the seed into the key
+            uint64_t state = seed_value.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < key.size(); i += 2) {
+                uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+                z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+                z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+                z ^= z >> 31;
+                key[i] = static_cast<uint32_t>(z);
+                key[i + 1] = static_cast<uint32_t>(z >> 32);
+            }
+            return {key, next_stream.fetch_add(1, std::memory_order_relaxed)};
+        }
+
+        std::random_device device;
+        for (auto& word: key) {
+            word = device();
+        }
+        return {key, 0};
+    }
+
+    static inline std::atomic<uint64_t> current_generation{0};
+    static inline std::atomic<bool> seeded{false};
+    static inline std::atomic<uint64_t> seed_value{0};
+    static inline std::atomic<uint64_t> next_stream{0};
+};
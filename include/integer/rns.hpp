@@ -0,0 +1,240 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Montgomery multiplication in a residue number system (Bajard / Kawamura base extension)
+ *
+ * A value is kept as its residues modulo 2k primes below 2^32: the first k form base B (product M), the other k
+ * base B' (product M'). The Montgomery product a * b * M^(-1) mod n costs independent word-size operations per
+ * channel plus two base extensions, each a k x k matrix-vector product:
+ *  - q = -a b n^(-1) mod M on B, extended to B' without correction (Bajard), which yields q + alpha M with alpha < k
+ *  - r = (a b + q n) / M on B', exact because r < M'
+ *  - r extended back to B exactly, its overflow alpha = floor(sum xi_j / m'_j) taken in floating point (Kawamura),
+ *    exact because r < M' / 2 keeps the fraction away from the next integer
+ *
+ * Results are not fully reduced: with c = k + 2, M >= c^2 n and M' >= 2 c n, operands below c n give a result
+ * below (k + 1) n, so products can be chained. Every channel is independent, the loops are plain loops over
+ * contiguous 32-bit words. Only available where the compiler provides a 128-bit integer (Barrett reduction).
+ */
+struct ResidueNumberSystem {
+#if defined(__SIZEOF_INT128__)
+    static constexpr bool available = true;
+
+    /**
+     * @brief arithmetic modulo one channel prime m < 2^32, Barrett reduction of 64-bit values
+     */
+    struct Channel {
+        explicit Channel(uint32_t t_mod)
+                : mod(t_mod), barrett(static_cast<uint64_t>((static_cast<unsigned __int128>(1) << 64) / t_mod)) {}
+
+        [[nodiscard]] uint32_t reduce(uint64_t x) const {
+            auto q = static_cast<uint64_t>((static_cast<unsigned __int128>(x) * barrett) >> 64);
+            uint64_t r = x - q * mod;
+            return static_cast<uint32_t>(r >= mod ? r - mod : r);
+        }
+
+        [[nodiscard]] uint32_t multiply(uint32_t a, uint32_t b) const {
+            return reduce(static_cast<uint64_t>(a) * b);
+        }
+
+        [[nodiscard]] uint32_t subtract(uint32_t a, uint32_t b) const {
+            return a >= b ? a - b : a + (mod - b);
+        }
+
+        [[nodiscard]] uint32_t inverse(uint32_t a) const {
+            int64_t r0 = mod, r1 = a, t0 = 0, t1 = 1;
+            while (r1 != 0) {
+                int64_t q = r0 / r1;
+                r0 -= q * r1;
+                std::swap(r0, r1);
+                t0 -= q * t1;
+                std::swap(t0, t1);
+            }
+            if (r0 != 1) {
+                throw std::invalid_argument("no inverse modulo the channel prime");
+            }
+            return static_cast<uint32_t>(t0 < 0 ? t0 + mod : t0);
+        }
+
+        uint64_t mod;
+        uint64_t barrett;
+    };
+
+    /**
+     * @brief the largest primes below 2^32 in descending order, computed once
+     */
+    static const std::vector<uint32_t>& primes() {
+        static const std::vector<uint32_t> table = [] {
+            constexpr size_t count = 2048;
+            std::vector<uint32_t> result;
+            for (uint64_t candidate = 0xffffffffu; result.size() < count; candidate -= 2) {
+                if (is_prime(candidate)) result.push_back(static_cast<uint32_t>(candidate));
+            }
+            return result;
+        }();
+        return table;
+    }
+
+    /**
+     * @param moduli 2k distinct primes below 2^32, base B first
+     * @param n_residues n mod every prime of `moduli`, n coprime to the primes of B
+     */
+    ResidueNumberSystem(const std::vector<uint32_t>& moduli, const std::vector<uint32_t>& n_residues)
+            : k(moduli.size() / 2) {
+        if (moduli.size() != 2 * k or n_residues.size() != moduli.size() or k == 0) {
+            throw std::invalid_argument("an RNS needs two bases of the same size");
+        }
+        for (uint32_t m: moduli) channels.emplace_back(m);
+
+        const Channel* base = channels.data();
+        const Channel* base_prime = channels.data() + k;
+
+        // B: xi_i = s_i * (-n^(-1)) * (M / m_i)^(-1) mod m_i
+        for (size_t i = 0; i < k; i++) {
+            const Channel& c = channels[i];
+            uint32_t negative_n_inverse = c.subtract(0, c.inverse(n_residues[i]));
+            q_factor.push_back(c.multiply(negative_n_inverse, c.inverse(cofactors(c, base, k)[i])));
+        }
+
+        // B': the extension rows (M / m_i) mod m'_j, n mod m'_j and xi'_j = u_j * M^(-1) * (M' / m'_j)^(-1) mod m'_j
+        for (size_t j = 0; j < k; j++) {
+            const Channel& c = base_prime[j];
+            auto row = cofactors(c, base, k);
+            extend_to_b_prime.insert(extend_to_b_prime.end(), row.begin(), row.end());
+            n_mod.push_back(n_residues[k + j]);
+            m_inverse.push_back(c.inverse(c.multiply(row[0], c.reduce(base[0].mod))));
+            crt_inverse.push_back(c.inverse(cofactors(c, base_prime, k)[j]));
+            reciprocal.push_back(1.0 / static_cast<double>(c.mod));
+        }
+
+        // B: the extension rows (M' / m'_j) mod m_i and M' mod m_i for the overflow correction
+        for (size_t i = 0; i < k; i++) {
+            const Channel& c = base[i];
+            auto row = cofactors(c, base_prime, k);
+            extend_to_b.insert(extend_to_b.end(), row.begin(), row.end());
+            b_prime_product.push_back(c.multiply(row[0], c.reduce(base_prime[0].mod)));
+        }
+    }
+
+    [[nodiscard]] size_t size() const {
+        return 2 * k;
+    }
+
+    /**
+     * @brief out = a * b * M^(-1) mod n (not fully reduced), all three of `size()` residues, out may alias a or b
+     * @param scratch `size()` words
+     */
+    void multiply(const uint32_t* a, const uint32_t* b, uint32_t* out, uint32_t* scratch) const {
+        for (size_t c = 0; c < 2 * k; c++) {
+            out[c] = channels[c].multiply(a[c], b[c]);
+        }
+
+        uint32_t* xi = scratch;
+        for (size_t i = 0; i < k; i++) {
+            xi[i] = channels[i].multiply(out[i], q_factor[i]);
+        }
+
+        uint32_t* xi_prime = scratch + k;
+        double overflow = 0.25;
+        for (size_t j = 0; j < k; j++) {
+            const Channel& c = channels[k + j];
+            uint32_t q = dot(&extend_to_b_prime[j * k], xi, c);
+            uint32_t u = c.reduce(out[k + j] + static_cast<uint64_t>(c.multiply(q, n_mod[j])));
+            uint32_t r = c.multiply(u, m_inverse[j]);
+            out[k + j] = r;
+            xi_prime[j] = c.multiply(r, crt_inverse[j]);
+            overflow += xi_prime[j] * reciprocal[j];
+        }
+
+        auto alpha = static_cast<uint64_t>(overflow);
+        for (size_t i = 0; i < k; i++) {
+            const Channel& c = channels[i];
+            out[i] = c.subtract(dot(&extend_to_b[i * k], xi_prime, c), c.reduce(alpha * b_prime_product[i]));
+        }
+    }
+
+    size_t k;
+    std::vector<Channel> channels;
+    std::vector<uint32_t> q_factor;
+    std::vector<uint32_t> extend_to_b_prime;
+    std::vector<uint32_t> n_mod;
+    std::vector<uint32_t> m_inverse;
+    /**
+     * (M' / m'_j)^(-1) mod m'_j
+     */
+    std::vector<uint32_t> crt_inverse;
+    std::vector<double> reciprocal;
+    std::vector<uint32_t> extend_to_b;
+    std::vector<uint32_t> b_prime_product;
+
+private:
+    /**
+     * @brief sum row[i] * x[i] mod c over k terms; the 64-bit products are summed as separate low / high halves,
+     * so nothing overflows and the loop stays free of reductions
+     */
+    [[nodiscard]] uint32_t dot(const uint32_t* row, const uint32_t* x, const Channel& c) const {
+        uint64_t low = 0, high = 0;
+        for (size_t i = 0; i < k; i++) {
+            uint64_t product = static_cast<uint64_t>(row[i]) * x[i];
+            low += static_cast<uint32_t>(product);
+            high += product >> 32;
+        }
+        uint32_t shifted = c.reduce(static_cast<uint64_t>(c.reduce(high)) << 32);
+        return c.reduce(static_cast<uint64_t>(shifted) + c.reduce(low));
+    }
+
+    /**
+     * @brief (product of all moduli / moduli[i]) mod c for every i, from prefix and suffix products
+     */
+    static std::vector<uint32_t> cofactors(const Channel& c, const Channel* moduli, size_t count) {
+        std::vector<uint32_t> result(count);
+        uint32_t prefix = 1;
+        for (size_t i = 0; i < count; i++) {
+            result[i] = prefix;
+            prefix = c.multiply(prefix, c.reduce(moduli[i].mod));
+        }
+        uint32_t suffix = 1;
+        for (size_t i = count; i-- > 0;) {
+            result[i] = c.multiply(result[i], suffix);
+            suffix = c.multiply(suffix, c.reduce(moduli[i].mod));
+        }
+        return result;
+    }
+
+    /**
+     * @brief deterministic Miller-Rabin for 32-bit candidates (bases 2, 7, 61)
+     */
+    static bool is_prime(uint64_t n) {
+        if (n % 3 == 0 or n % 5 == 0 or n % 7 == 0) return false;
+        uint64_t d = n - 1;
+        int s = 0;
+        while (d % 2 == 0) {
+            d /= 2;
+            s++;
+        }
+        for (uint64_t a: {2u, 7u, 61u}) {
+            uint64_t x = 1, base = a, e = d;
+            while (e > 0) {
+                if (e & 1) x = x * base % n;
+                base = base * base % n;
+                e >>= 1;
+            }
+            if (x == 1 or x == n - 1) continue;
+            bool composite = true;
+            for (int i = 1; i < s and composite; i++) {
+                x = x * x % n;
+                composite = x != n - 1;
+            }
+            if (composite) return false;
+        }
+        return true;
+    }
+#else
+    static constexpr bool available = false;
+#endif
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+
+/**
+ * @brief contiguous buffer of trivially copyable elements with inline storage for the first `inline_count` ones
+ *
+ * Only spills to the heap when resized beyond `inline_count`. New elements are zero initialized like
+ * with `std::vector<T>::resize`.
+ *
+ * @tparam T element type, trivially copyable
+ * @tparam inline_count
+ * @tparam Allocator allocator of the heap buffer
+ */
+template<typename T, size_t inline_count, typename Allocator = std::allocator<T>>
+struct SmallVector {
+    static_assert(std::is_trivially_copyable_v<T> and inline_count > 0);
+
+    SmallVector() = default;
+
+    SmallVector(const T* first, const T* last) {
+        resize(last - first);
+        std::copy(first, last, ptr);
+    }
+
+    SmallVector(const SmallVector& other) : SmallVector(other.begin(), other.end()) {}
+
+    SmallVector& operator=(const SmallVector& other) {
+        if (this != &other) {
+            reserve(other.count);
+            count = other.count;
+            std::copy(other.begin(), other.end(), ptr);
+        }
+        return *this;
+    }
+
+    SmallVector(SmallVector&& other) noexcept {
+        steal(other);
+    }
+
+    SmallVector& operator=(SmallVector&& other) noexcept {
+        if (this != &other) {
+            release();
+            steal(other);
+        }
+        return *this;
+    }
+
+    ~SmallVector() {
+        release();
+    }
+
+    void resize(size_t new_count) {
+        reserve(new_count);
+        if (new_count > count) {
+            std::fill(ptr + count, ptr + new_count, T{});
+        }
+        count = new_count;
+    }
+
+    void reserve(size_t new_capacity) {
+        if (new_capacity <= capacity) return;
+
+        new_capacity = std::max(new_capacity, capacity + capacity / 2);
+        T* buffer = std::allocator_traits<Allocator>::allocate(allocator, new_capacity);
+        std::copy(ptr, ptr + count, buffer);
+        release();
+        ptr = buffer;
+        capacity = new_capacity;
+    }
+
+    [[nodiscard]] bool is_inline() const {
+        return ptr == inline_storage;
+    }
+
+    [[nodiscard]] size_t size() const { return count; }
+    [[nodiscard]] bool empty() const { return count == 0; }
+
+    T* data() { return ptr; }
+    const T* data() const { return ptr; }
+
+    T* begin() { return ptr; }
+    T* end() { return ptr + count; }
+    const T* begin() const { return ptr; }
+    const T* end() const { return ptr + count; }
+
+    T& operator[](size_t i) { return ptr[i]; }
+    const T& operator[](size_t i) const { return ptr[i]; }
+
+private:
+    void release() {
+        if (not is_inline()) {
+            std::allocator_traits<Allocator>::deallocate(allocator, ptr, capacity);
+            ptr = inline_storage;
+            capacity = inline_count;
+        }
+    }
+
+    /**
+     * @brief take the heap buffer of other, or copy its inline elements, and leave it empty
+     */
+    void steal(SmallVector& other) {
+        if (other.is_inline()) {
+            ptr = inline_storage;
+            capacity = inline_count;
+            std::copy(other.begin(), other.end(), ptr);
+        } else {
+            ptr = other.ptr;
+            capacity = other.capacity;
+            other.ptr = other.inline_storage;
+            other.capacity = inline_count;
+        }
+        count = other.count;
+        other.count = 0;
+    }
+
+    T inline_storage[inline_count];
+    [[no_unique_address]] Allocator allocator;
+    T* ptr = inline_storage;
+    size_t count = 0;
+    size_t capacity = inline_count;
+};
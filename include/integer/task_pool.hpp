@@ -0,0 +1,282 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <vector>
+
+#include "arena.hpp"
+
+/**
+ * @brief work-stealing pool for fork / join parallelism inside one operation (e.g. one huge product)
+ *
+ * Every worker has its own deque: it pushes and pops its own tasks at the back, idle workers steal from the
+ * front of the others. A caller that waits for a task runs other queued tasks meanwhile instead of blocking,
+ * so nested `invoke`s never deadlock.
+ *
+ * A task is only handed to the pool while some worker is idle, otherwise the caller runs it itself. Calls from
+ * code that is already parallel (every core busy) therefore stay sequential instead of oversubscribing.
+ */
+struct TaskPool {
+    /**
+     * worker count of `global()`, read when it is first used
+     */
+    static inline size_t global_workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+    static TaskPool& global() {
+        static TaskPool pool(global_workers);
+        return pool;
+    }
+
+    explicit TaskPool(size_t worker_count) : queues(worker_count + 1) {
+        for (size_t i = 0; i < worker_count; i++) {
+            workers.emplace_back([this, i](std::stop_token stop_token) { work(i, stop_token); });
+        }
+    }
+
+    ~TaskPool() {
+        for (auto& worker: workers) {
+            worker.request_stop();
+        }
+        {
+            std::scoped_lock lock(sleep_mutex);
+            wake.notify_all();
+        }
+        workers.clear();
+    }
+
+    TaskPool(const TaskPool&) = delete;
+    TaskPool& operator=(const TaskPool&) = delete;
+
+    [[nodiscard]] size_t size() const {
+        return workers.size();
+    }
+
+    /**
+     * @brief run all functions, the first on the calling thread and the others on idle workers if there are any
+     *
+     * Returns when all have finished; the first exception thrown by one of them is rethrown.
+     */
+    template<typename First, typename... Rest>
+    void invoke(First&& first, Rest&&... rest) {
+        std::tuple<Job<Rest>...> jobs{rest...};
+        std::apply([&](auto&... job) { (submit(job), ...); }, jobs);
+
+        std::exception_ptr error;
+        try {
+            first();
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        std::apply([&](auto&... job) { (join(job, error), ...); }, jobs);
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+    /**
+     * @brief f(i) for every i in [0, count), the same way as `invoke`: f(0) on the calling thread, the others
+     *        on idle workers if there are any
+     */
+    template<typename F>
+    void for_each(size_t count, F&& f) {
+        if (count == 0) return;
+
+        std::vector<Call<F>> calls;
+        for (size_t i = 1; i < count; i++) {
+            calls.push_back({&f, i});
+        }
+        std::deque<Job<Call<F>>> jobs;
+        for (auto& call: calls) {
+            submit(jobs.emplace_back(call));
+        }
+
+        std::exception_ptr error;
+        try {
+            f(size_t{0});
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        for (auto& job: jobs) {
+            join(job, error);
+        }
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    /**
+     * @brief f(index) as a function without arguments
+     */
+    template<typename F>
+    struct Call {
+        std::remove_reference_t<F>* function;
+        size_t index;
+
+        void operator()() const {
+            (*function)(index);
+        }
+    };
+
+    struct Task {
+        void (*run)(Task*);
+        std::atomic<bool> done{false};
+        bool queued = false;
+        size_t queue = 0;
+        std::exception_ptr error;
+    };
+
+    template<typename F>
+    struct Job : Task {
+        explicit Job(F& f) : function(f) {
+            this->run = [](Task* task) {
+                auto job = static_cast<Job*>(task);
+                try {
+                    job->function();
+                } catch (...) {
+                    job->error = std::current_exception();
+                }
+            };
+        }
+
+        F& function;
+    };
+
+    struct Queue {
+        std::mutex mutex;
+        std::deque<Task*> tasks;
+    };
+
+    /**
+     * @brief queue index of the calling thread, the last queue is shared by all threads outside the pool
+     */
+    size_t local_queue() const {
+        return current_pool == this ? current_index : queues.size() - 1;
+    }
+
+    void submit(Task& task) {
+        if (idle.load(std::memory_order_acquire) == 0) return;
+
+        task.queue = local_queue();
+        {
+            std::scoped_lock lock(queues[task.queue].mutex);
+            queues[task.queue].tasks.push_back(&task);
+        }
+        task.queued = true;
+        {
+            std::scoped_lock lock(sleep_mutex);
+            pending++;
+        }
+        wake.notify_one();
+    }
+
+    /**
+     * @brief run the task here if no worker took it yet, otherwise help with other tasks until it is done
+     */
+    void join(Task& task, std::exception_ptr& error) {
+        bool reclaimed = not task.queued;
+        if (task.queued) {
+            auto& queue = queues[task.queue];
+            std::scoped_lock lock(queue.mutex);
+            auto it = std::find(queue.tasks.rbegin(), queue.tasks.rend(), &task);
+            if (it != queue.tasks.rend()) {
+                queue.tasks.erase(std::next(it).base());
+                reclaimed = true;
+            }
+        }
+
+        if (reclaimed) {
+            if (task.queued) {
+                std::scoped_lock lock(sleep_mutex);
+                pending--;
+            }
+            task.run(&task);
+        } else {
+            while (not task.done.load(std::memory_order_acquire)) {
+                if (not run_one(local_queue())) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+
+        if (task.error and not error) {
+            error = task.error;
+        }
+    }
+
+    /**
+     * @brief one task from the back of our queue or stolen from the front of another one
+     */
+    Task* take(size_t index) {
+        {
+            auto& own = queues[index];
+            std::scoped_lock lock(own.mutex);
+            if (not own.tasks.empty()) {
+                Task* task = own.tasks.back();
+                own.tasks.pop_back();
+                return task;
+            }
+        }
+        for (size_t offset = 1; offset < queues.size(); offset++) {
+            auto& other = queues[(index + offset) % queues.size()];
+            std::scoped_lock lock(other.mutex);
+            if (not other.tasks.empty()) {
+                Task* task = other.tasks.front();
+                other.tasks.pop_front();
+                return task;
+            }
+        }
+        return nullptr;
+    }
+
+    bool run_one(size_t index) {
+        Task* task = take(index);
+        if (task == nullptr) return false;
+        {
+            std::scoped_lock lock(sleep_mutex);
+            pending--;
+        }
+
+        // the result goes to another thread, only scopes opened by the task itself use this thread's arena
+        TaskArenaFrame frame;
+        task->run(task);
+        task->done.store(true, std::memory_order_release);
+        return true;
+    }
+
+    void work(size_t index, std::stop_token stop_token) {
+        current_pool = this;
+        current_index = index;
+        while (not stop_token.stop_requested()) {
+            if (run_one(index)) continue;
+
+            std::unique_lock lock(sleep_mutex);
+            idle++;
+            wake.wait(lock, [&] { return pending > 0 or stop_token.stop_requested(); });
+            idle--;
+        }
+    }
+
+    static inline thread_local const TaskPool* current_pool = nullptr;
+    static inline thread_local size_t current_index = 0;
+
+    std::vector<Queue> queues;
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    /**
+     * queued tasks, guarded by sleep_mutex
+     */
+    size_t pending = 0;
+    std::atomic<size_t> idle{0};
+    std::vector<std::jthread> workers;
+};
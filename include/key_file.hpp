@@ -0,0 +1,81 @@
+#pragma once
+
+#include <istream>
+#include <map>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "rsa.hpp"
+
+/**
+ * @brief text key format shared by `rsa_cli` and `librsa`
+ *
+ * One `name=0x...` line per key component (n, e, d, p, q), multi-prime keys add r2, r3, ...
+ * A public key only has n and e. Keys with batch exponents add b0 (= e), b1, ...
+ */
+inline void write_key(std::ostream& out, const RSA<BigInt>& rsa, bool include_private = true) {
+    out << "n=" << rsa.public_key.n.to_string() << "\n"
+        << "e=" << rsa.public_key.e.to_string() << "\n";
+    for (size_t i = 0; i < rsa.batch_exponents.size(); i++) {
+        out << "b" << i << "=" << rsa.batch_exponents[i].to_string() << "\n";
+    }
+    if (not include_private or rsa.private_key.d.is_zero()) return;
+
+    out << "d=" << rsa.private_key.d.to_string() << "\n";
+    if (rsa.private_key.primes.size() < 2) return;
+    out << "p=" << rsa.private_key.p.to_string() << "\n"
+        << "q=" << rsa.private_key.q.to_string() << "\n";
+    for (size_t i = 2; i < rsa.private_key.primes.size(); i++) {
+        out << "r" << i << "=" << rsa.private_key.primes[i].to_string() << "\n";
+    }
+}
+
+/**
+ * @brief read a key written by `write_key` and pick its kernels
+ * @return whether the key contains the private exponent
+ */
+inline bool read_key(std::istream& in, RSA<BigInt>& rsa) {
+    std::map<std::string, BigInt> values;
+    std::string line;
+    while (std::getline(in, line)) {
+        auto pos = line.find('=');
+        if (pos == std::string::npos) continue;
+        values[line.substr(0, pos)] = BigInt(std::string_view(line).substr(pos + 1));
+    }
+
+    if (not values.contains("n") or not values.contains("e")) {
+        throw std::invalid_argument("key needs at least n and e");
+    }
+
+    rsa.public_key = {values["n"], values["e"]};
+    bool has_private;
+    if (values.contains("p") and values.contains("q")) {
+        std::vector<BigInt> primes = {values["p"], values["q"]};
+        for (size_t i = 2; values.contains("r" + std::to_string(i)); i++) {
+            primes.push_back(values["r" + std::to_string(i)]);
+        }
+        rsa.private_key = rsa.make_private_key(primes, rsa.public_key.e);
+        if (not (rsa.private_key.n == rsa.public_key.n)) {
+            throw std::invalid_argument("the primes of the key do not multiply to n");
+        }
+        has_private = true;
+    } else {
+        rsa.private_key.n = values["n"];
+        if (values.contains("d")) rsa.private_key.d = values["d"];
+        has_private = values.contains("d");
+    }
+
+    // exponents of a previously held key must not survive into this one
+    rsa.batch_exponents.clear();
+    for (size_t i = 0; values.contains("b" + std::to_string(i)); i++) {
+        rsa.batch_exponents.push_back(values["b" + std::to_string(i)]);
+    }
+    if (not rsa.batch_exponents.empty() and not rsa.batch_exponents_match_key()) {
+        throw std::invalid_argument("the batch exponents do not fit the key");
+    }
+
+    rsa.select_kernels();
+    return has_private;
+}
@@ -0,0 +1,260 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#endif
+
+#include "spdlog/spdlog.h"
+
+#include "rsa.hpp"
+
+/**
+ * @brief pool of pregenerated RSA key pairs, refilled in the background
+ *
+ * Prime search time is random, so a caller waiting on `generate_key_pair` sees very uneven latency.
+ * The pool keeps up to `capacity` ready key pairs per key length. A single refill thread runs with
+ * idle scheduling priority (the prime search threads it spawns inherit it), so refilling only uses
+ * otherwise idle cores.
+ *
+ * @tparam IntegerType Biginteger Type
+ */
+template<typename IntegerType>
+struct KeyPairPool {
+    using RSAType = RSA<IntegerType>;
+    using KeyPair = std::pair<typename RSAType::PublicKey, typename RSAType::PrivateKey>;
+    using Clock = std::chrono::steady_clock;
+
+    struct Metrics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t generated = 0;
+
+        /**
+         * refill lag: time between a slot of the pool becoming empty and a new key pair filling it
+         */
+        Clock::duration last_refill_lag{};
+        Clock::duration max_refill_lag{};
+        Clock::duration total_refill_lag{};
+
+        [[nodiscard]] double hit_rate() const {
+            size_t total = hits + misses;
+            return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+        }
+
+        [[nodiscard]] Clock::duration mean_refill_lag() const {
+            if (generated == 0) return {};
+            return total_refill_lag / static_cast<Clock::rep>(generated);
+        }
+    };
+
+    /**
+     * @param default_capacity capacity used for key lengths first seen by `take`
+     * @param background start the refill thread, otherwise the pool is only filled by `refill_one`
+     */
+    explicit KeyPairPool(size_t default_capacity = 4, bool background = true) : default_capacity(default_capacity) {
+        if (background) {
+            worker = std::jthread([this](std::stop_token stop_token) { refill_loop(stop_token); });
+        }
+    }
+
+    ~KeyPairPool() {
+        if (worker.joinable()) {
+            worker.request_stop();
+            cv.notify_all();
+            worker.join();
+        }
+    }
+
+    KeyPairPool(const KeyPairPool&) = delete;
+    KeyPairPool& operator=(const KeyPairPool&) = delete;
+
+    /**
+     * @brief keep `capacity` ready key pairs of length `len`
+     *
+     * A smaller capacity drops the surplus, pending refills first (the newest ones), then ready key pairs.
+     * @param len key length, same meaning as in `RSA::generate_key_pair`
+     * @param capacity
+     */
+    void reserve(size_t len, size_t capacity) {
+        {
+            std::scoped_lock lock(mutex);
+            auto& slot = slots[len];
+            slot.capacity = capacity;
+            while (slot.keys.size() > capacity) {
+                slot.keys.pop_back();
+            }
+            while (slot.keys.size() + slot.pending_since.size() > capacity) {
+                slot.pending_since.pop_back();
+            }
+            while (slot.keys.size() + slot.pending_since.size() < capacity) {
+                slot.pending_since.push_back(Clock::now());
+            }
+        }
+        cv.notify_all();
+    }
+
+    /**
+     * @brief take a key pair, generating it synchronously if the pool for `len` is empty
+     * @param len
+     * @return [public key, private key]
+     */
+    KeyPair take(size_t len) {
+        if (auto key_pair = try_take(len)) {
+            return std::move(*key_pair);
+        }
+
+        RSAType rsa;
+        return rsa.generate_key_pair(len);
+    }
+
+    /**
+     * @brief take a key pair only if one is ready
+     * @param len
+     * @return the key pair or std::nullopt, the latter counted as a miss
+     */
+    std::optional<KeyPair> try_take(size_t len) {
+        std::optional<KeyPair> result;
+        {
+            std::scoped_lock lock(mutex);
+            auto [it, inserted] = slots.try_emplace(len);
+            auto& slot = it->second;
+            if (inserted) {
+                slot.capacity = default_capacity;
+                slot.pending_since.assign(default_capacity, Clock::now());
+            }
+
+            if (slot.keys.empty()) {
+                metrics_.misses++;
+            } else {
+                metrics_.hits++;
+                result = std::move(slot.keys.front());
+                slot.keys.pop_front();
+                slot.pending_since.push_back(Clock::now());
+            }
+        }
+        cv.notify_all();
+        return result;
+    }
+
+    /**
+     * @brief generate one key pair for the slot waiting longest, on the calling thread
+     * @return false if every slot is full
+     */
+    bool refill_one() {
+        auto len = next_refill_length();
+        if (not len.has_value()) return false;
+
+        RSAType rsa;
+        auto key_pair = rsa.generate_key_pair(*len);
+        store(*len, std::move(key_pair));
+        return true;
+    }
+
+    [[nodiscard]] size_t available(size_t len) const {
+        std::scoped_lock lock(mutex);
+        auto it = slots.find(len);
+        return it == slots.end() ? 0 : it->second.keys.size();
+    }
+
+    [[nodiscard]] Metrics metrics() const {
+        std::scoped_lock lock(mutex);
+        return metrics_;
+    }
+
+private:
+    struct Slot {
+        size_t capacity = 0;
+        std::deque<KeyPair> keys;
+        /**
+         * one entry per missing key pair, the time that slot became empty
+         */
+        std::deque<Clock::time_point> pending_since;
+    };
+
+    std::optional<size_t> next_refill_length() {
+        std::scoped_lock lock(mutex);
+        return next_refill_length_locked();
+    }
+
+    std::optional<size_t> next_refill_length_locked() {
+        std::optional<size_t> result;
+        Clock::time_point oldest = Clock::time_point::max();
+        for (auto& [len, slot]: slots) {
+            if (not slot.pending_since.empty() and slot.pending_since.front() < oldest) {
+                oldest = slot.pending_since.front();
+                result = len;
+            }
+        }
+        return result;
+    }
+
+    void store(size_t len, KeyPair&& key_pair) {
+        std::scoped_lock lock(mutex);
+        auto& slot = slots[len];
+        if (slot.pending_since.empty()) return;
+
+        auto lag = Clock::now() - slot.pending_since.front();
+        slot.pending_since.pop_front();
+        slot.keys.push_back(std::move(key_pair));
+
+        metrics_.generated++;
+        metrics_.last_refill_lag = lag;
+        metrics_.max_refill_lag = std::max(metrics_.max_refill_lag, lag);
+        metrics_.total_refill_lag += lag;
+    }
+
+    static void lower_current_thread_priority() {
+#if defined(__linux__)
+        sched_param param{};
+        if (pthread_setschedparam(pthread_self(), SCHED_IDLE, &param) != 0) {
+            setpriority(PRIO_PROCESS, 0, 19);
+        }
+#endif
+    }
+
+    void refill_loop(std::stop_token stop_token) {
+        lower_current_thread_priority();
+
+        RSAType rsa;
+        while (not stop_token.stop_requested()) {
+            std::optional<size_t> len;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, stop_token, [&] {
+                    len = next_refill_length_locked();
+                    return len.has_value();
+                });
+            }
+            if (not len.has_value()) break;
+
+            try {
+                // the destructor cancels a running search instead of waiting for it
+                auto key_pair = rsa.generate_key_pair(*len, KeyGenOptions{.stop_token = stop_token});
+                store(*len, std::move(key_pair));
+            } catch (SearchCancelled&) {
+                break;
+            } catch (std::exception& e) {
+                spdlog::error(e.what());
+            }
+        }
+    }
+
+    size_t default_capacity;
+
+    mutable std::mutex mutex;
+    std::condition_variable_any cv;
+    std::map<size_t, Slot> slots;
+    Metrics metrics_;
+
+    std::jthread worker;
+};
@@ -0,0 +1,135 @@
+#ifndef RSA_H
+#define RSA_H
+
+/**
+ * @brief C API of librsa, for FFI callers (Go, Rust, ...)
+ *
+ * Keys are opaque handles owned by the library and released with `rsa_key_free`. All other memory is the
+ * caller's: inputs and outputs are caller-owned byte buffers of big-endian integers. Outputs fill their whole
+ * buffer right-aligned (zero padded); signature and cipher buffers need at least `rsa_key_modulus_bytes` (k).
+ *
+ * A key is immutable once created, so any number of threads may use the same handle concurrently. The
+ * per-key precomputation (CRT parameters, Montgomery context of n, blinding pairs per thread) is done once
+ * and reused by every call.
+ *
+ * Batch functions take `count` records laid out back to back and spread them over the cores.
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(__GNUC__)
+#define RSA_API __attribute__((visibility("default")))
+#else
+#define RSA_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum rsa_status {
+    RSA_OK = 0,
+    /** null pointer, zero or inconsistent size, malformed key */
+    RSA_ERROR_INVALID_ARGUMENT = 1,
+    /** the output does not fit, the required size is reported where the function has a size out parameter */
+    RSA_ERROR_BUFFER_TOO_SMALL = 2,
+    /** the input is not less than the modulus */
+    RSA_ERROR_OUT_OF_RANGE = 3,
+    /** sign / decrypt under a key without the private exponent */
+    RSA_ERROR_NO_PRIVATE_KEY = 4,
+    RSA_ERROR_OUT_OF_MEMORY = 5,
+    RSA_ERROR_INTERNAL = 6
+} rsa_status;
+
+typedef struct rsa_key rsa_key;
+
+RSA_API const char* rsa_status_string(rsa_status status);
+
+/**
+ * @brief generate a key pair whose modulus has `bits` bits (a multiple of 8, at least 64) and `prime_count` (>= 2)
+ *        prime factors
+ *
+ * The modulus has exactly `bits` bits for every prime count, so `rsa_key_modulus_bytes` is `bits / 8`.
+ */
+RSA_API rsa_status rsa_key_generate(size_t bits, size_t prime_count, rsa_key** key);
+
+/**
+ * @brief load a key in the `rsa_cli` key file format (`name=0x...` lines), public or private
+ */
+RSA_API rsa_status rsa_key_load(const uint8_t* data, size_t length, rsa_key** key);
+
+/**
+ * @brief public key from the big-endian modulus and public exponent
+ */
+RSA_API rsa_status rsa_public_key_load(const uint8_t* n, size_t n_length, const uint8_t* e, size_t e_length,
+                                       rsa_key** key);
+
+/**
+ * @brief write the key in the format read by `rsa_key_load`, without the private part unless `include_private`
+ * @param length in: size of `data`, out: bytes written, or bytes required with RSA_ERROR_BUFFER_TOO_SMALL
+ *        (`data` may be null to query the size)
+ */
+RSA_API rsa_status rsa_key_store(const rsa_key* key, int include_private, uint8_t* data, size_t* length);
+
+/**
+ * @brief big-endian n (`n_length` >= k) and e, the inverse of `rsa_public_key_load`
+ */
+RSA_API rsa_status rsa_public_key_store(const rsa_key* key, uint8_t* n, size_t n_length, uint8_t* e, size_t e_length);
+
+RSA_API void rsa_key_free(rsa_key* key);
+
+/**
+ * @return size of n in bytes (k), 0 for a null key
+ */
+RSA_API size_t rsa_key_modulus_bytes(const rsa_key* key);
+
+RSA_API int rsa_key_has_private(const rsa_key* key);
+
+/**
+ * @brief signature = digest^d mod n
+ */
+RSA_API rsa_status rsa_sign(const rsa_key* key, const uint8_t* digest, size_t digest_length,
+                            uint8_t* signature, size_t signature_length);
+
+/**
+ * @brief `*valid` = 1 if signature^e mod n equals the digest, 0 otherwise (also for a signature >= n)
+ */
+RSA_API rsa_status rsa_verify(const rsa_key* key, const uint8_t* digest, size_t digest_length,
+                              const uint8_t* signature, size_t signature_length, int* valid);
+
+/**
+ * @brief cipher = message^e mod n
+ */
+RSA_API rsa_status rsa_encrypt(const rsa_key* key, const uint8_t* message, size_t message_length,
+                               uint8_t* cipher, size_t cipher_length);
+
+/**
+ * @brief message = cipher^d mod n, RSA_ERROR_BUFFER_TOO_SMALL if it needs more than `message_length` bytes
+ */
+RSA_API rsa_status rsa_decrypt(const rsa_key* key, const uint8_t* cipher, size_t cipher_length,
+                               uint8_t* message, size_t message_length);
+
+/**
+ * @brief `count` digests of `digest_length` bytes each to `count` signatures of `signature_length` bytes each
+ */
+RSA_API rsa_status rsa_sign_batch(const rsa_key* key, size_t count, const uint8_t* digests, size_t digest_length,
+                                  uint8_t* signatures, size_t signature_length);
+
+/**
+ * @brief one byte per record in `valid`, 1 valid / 0 invalid
+ */
+RSA_API rsa_status rsa_verify_batch(const rsa_key* key, size_t count, const uint8_t* digests, size_t digest_length,
+                                    const uint8_t* signatures, size_t signature_length, uint8_t* valid);
+
+RSA_API rsa_status rsa_encrypt_batch(const rsa_key* key, size_t count, const uint8_t* messages, size_t message_length,
+                                     uint8_t* ciphers, size_t cipher_length);
+
+RSA_API rsa_status rsa_decrypt_batch(const rsa_key* key, size_t count, const uint8_t* ciphers, size_t cipher_length,
+                                     uint8_t* messages, size_t message_length);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RSA_H
@@ -1,9 +1,63 @@
 #pragma once
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <future>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <thread>
+#include <tuple>
+
 #include "spdlog/spdlog.h"
 
 #include "integer/integer.hpp"
 #include "integer/prime_generator.hpp"
+#include "sha256.hpp"
+
+enum class KeyGenMode {
+    /**
+     * search the primes one after another, each search using every core
+     */
+    sequential,
+    /**
+     * one shared pool of search threads looks for all primes at once
+     */
+    concurrent
+};
+
+enum class KeyGenPhase {
+    searching_primes,
+    building_key,
+    done
+};
+
+/**
+ * @brief progress of a running `generate_key_pair`, may be read from any thread
+ */
+struct KeyGenProgress : SearchProgress {
+    std::atomic<KeyGenPhase> phase{KeyGenPhase::searching_primes};
+};
+
+/**
+ * @brief cancellation, deadline and progress reporting of `generate_key_pair`
+ */
+struct KeyGenOptions {
+    size_t prime_count = 2;
+    std::stop_token stop_token{};
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    /**
+     * optional, updated while the key is generated
+     */
+    std::shared_ptr<KeyGenProgress> progress{};
+    /**
+     * pairwise coprime small public exponents sharing n for `batch_decrypt`, the first one becomes e;
+     * empty for a single exponent chosen by `choose_e`
+     */
+    std::vector<uint64_t> batch_exponents{};
+};
 
 /**
  * @brief RSA implementation
@@ -11,6 +65,13 @@
  */
 template<typename IntegerType>
 struct RSA {
+    KeyGenMode keygen_mode = KeyGenMode::concurrent;
+
+    /**
+     * base blinding of decrypt / sign against timing attacks, see `blinded_private_exp_mod`
+     */
+    bool blinding = true;
+
     IntegerType generate_prime(size_t hex_bit_count) {
         auto result = PrimeGenerator<IntegerType>::get_prime(hex_bit_count);
         return result;
@@ -27,6 +88,21 @@ struct RSA {
         BigInt n;
         BigInt d;
         BigInt phi;
+
+        /**
+         * all prime factors r_0 .. r_{k-1} of n (multi-prime RSA, k >= 2), r_0 = p and r_1 = q
+         */
+        std::vector<BigInt> primes;
+
+        /**
+         * CRT exponents, d mod (r_i - 1)
+         */
+        std::vector<BigInt> exponents;
+
+        /**
+         * CRT coefficients, (r_0 * ... * r_{i-1})^{-1} mod r_i, the first one is unused
+         */
+        std::vector<BigInt> coefficients;
     };
 
     /**
@@ -35,10 +111,10 @@ struct RSA {
      * @return
      */
     BigInt encrypt(const BigInt& message) {
-        spdlog::info(message.to_string());
-        spdlog::info(public_key.e.to_string());
-        spdlog::info(public_key.n.to_string());
-        return BigInt::fast_odd_exp_mod(message, public_key.e, private_key.n);
+        spdlog::debug(message.to_string());
+        spdlog::debug(public_key.e.to_string());
+        spdlog::debug(public_key.n.to_string());
+        return ArenaScope::run([&] { return public_exp(message); });
     }
 
     /**
@@ -47,7 +123,105 @@ struct RSA {
      * @return the byte representation of the message
      */
     BigInt decrypt(const BigInt& cipher) {
-        return BigInt::fast_odd_exp_mod(cipher, private_key.d, private_key.n);
+        return blinded_private_exp_mod(cipher);
+    }
+
+    /**
+     * @brief encrypt under the public exponent batch_exponents[index], for `batch_decrypt`
+     */
+    BigInt batch_encrypt(const BigInt& message, size_t index) {
+        return ArenaScope::run([&] { return public_exp(message, batch_exponents.at(index)); });
+    }
+
+    /**
+     * @brief Fiat's batch RSA: decrypt ciphers[i], encrypted under batch_exponents[i]
+     *
+     * Going up a binary product tree the ciphers are combined into v = prod c_i^(E / e_i), E = prod e_i,
+     * whose E-th root (the only full-size exponentiation, through the CRT) is the product A of all messages.
+     * Going down, a node with children L, R splits its A = A_L * A_R with X = 0 mod E_L, X = 1 mod E_R:
+     * A_R = A^X / (v_L^(X / E_L) * v_R^((X - 1) / E_R)) and A_L = A / A_R. All other exponents are small,
+     * and the divisions of one tree level share a single modular inverse.
+     *
+     * A cipher that is 0 or shares a factor with n has no inverse mod n; it stays out of the tree and is
+     * decrypted on its own.
+     */
+    std::vector<BigInt> batch_decrypt(const std::vector<BigInt>& ciphers) {
+        if (ciphers.size() > batch_exponents.size()) {
+            throw std::invalid_argument("more ciphers than batch exponents");
+        }
+        if (ciphers.empty()) return {};
+        if (private_key.primes.size() < 2) {
+            throw std::invalid_argument("batch decryption needs the prime factors of n");
+        }
+        if (not batch_exponents_match_key()) {
+            throw std::invalid_argument("batch exponents do not belong to the current key");
+        }
+
+        return ArenaScope::run([&] {
+            const BigInt& n = public_key.n;
+            std::vector<BigInt> messages(ciphers.size());
+
+            // units mod n go into the tree, the others are decrypted one by one
+            std::vector<size_t> indices;
+            std::vector<BigInt> units, exponents;
+            for (size_t i = 0; i < ciphers.size(); i++) {
+                BigInt cipher = ciphers[i] % n;
+                if (cipher.is_zero() or not (gcd(cipher, n) == 1)) {
+                    messages[i] = crt_exp_mod(cipher, batch_root_exponents(batch_exponents[i]));
+                    continue;
+                }
+                indices.push_back(i);
+                units.push_back(std::move(cipher));
+                exponents.push_back(batch_exponents[i]);
+            }
+            if (units.empty()) return messages;
+
+            std::vector<BatchNode> tree;
+            tree.reserve(2 * units.size());
+            batch_percolate_up(tree, units, exponents, 0, units.size());
+
+            // the E-th root of the root value
+            tree.back().message_product = crt_exp_mod(tree.back().value, batch_root_exponents(tree.back().exponent));
+
+            // top down, one level at a time
+            std::vector<size_t> level = {tree.size() - 1};
+            while (not level.empty()) {
+                std::vector<size_t> next, splits;
+                std::vector<BigInt> powers, divisors;
+                for (size_t index: level) {
+                    BatchNode& node = tree[index];
+                    if (node.left == BatchNode::leaf) {
+                        messages[indices[node.begin]] = std::move(node.message_product);
+                        continue;
+                    }
+
+                    const BatchNode& left = tree[node.left];
+                    const BatchNode& right = tree[node.right];
+                    BigInt x = left.exponent * mod_inverse(left.exponent % right.exponent, right.exponent);
+                    powers.push_back(public_exp(node.message_product, x));
+                    divisors.push_back((public_exp(left.value, x / left.exponent) *
+                                        public_exp(right.value, (x - 1) / right.exponent)) % n);
+                    splits.push_back(index);
+                    next.push_back(node.left);
+                    next.push_back(node.right);
+                }
+
+                // 1 / (A^X * divisor) for every node, from one inverse (Montgomery's trick)
+                std::vector<BigInt> products;
+                for (size_t i = 0; i < splits.size(); i++) {
+                    products.push_back((powers[i] * divisors[i]) % n);
+                }
+                std::vector<BigInt> inverses = batch_mod_inverse(products, n);
+                for (size_t i = 0; i < splits.size(); i++) {
+                    BatchNode& node = tree[splits[i]];
+                    // A_R = A^X / divisor, A_L = A / A_R = A * divisor / A^X
+                    tree[node.right].message_product = (((powers[i] * powers[i]) % n) * inverses[i]) % n;
+                    tree[node.left].message_product = (((node.message_product * divisors[i]) % n * divisors[i]) % n * inverses[i]) % n;
+                }
+                level = std::move(next);
+            }
+            return messages;
+        });
     }
 
     /**
@@ -56,7 +230,7 @@ struct RSA {
      * @return
      */
     BigInt sign(const BigInt& digest) {
-        return BigInt::fast_odd_exp_mod(digest, private_key.d, private_key.n);
+        return blinded_private_exp_mod(digest);
     }
 
     /**
@@ -66,62 +240,647 @@ struct RSA {
      * @return
      */
     bool verify(const BigInt& digest, const BigInt& signature) {
-        auto encrypted = BigInt::fast_odd_exp_mod(signature, public_key.e, private_key.n);
-        spdlog::info(encrypted.to_string());
-        spdlog::info(digest.to_string());
+        return ArenaScope::run([&] {
+            auto encrypted = public_exp(signature);
+            spdlog::debug(encrypted.to_string());
+            spdlog::debug(digest.to_string());
+
+            return encrypted == digest;
+        });
+    }
+
+    /**
+     * @brief RSASSA-PKCS1-v1_5 signature of the SHA-256 digest of message
+     */
+    BigInt sign_message(std::string_view message) {
+        return sign(encode_digest(Sha256::hash(message)));
+    }
+
+    bool verify_message(std::string_view message, const BigInt& signature) {
+        if (signature >= public_key.n) return false;
+        return verify(encode_digest(Sha256::hash(message)), signature);
+    }
+
+    /**
+     * @brief sign_message for every message, hashed eight at a time and spread over the cores
+     */
+    std::vector<BigInt> sign_messages(const std::vector<std::string_view>& messages) {
+        std::vector<BigInt> signatures(messages.size());
+        for_each_slice(messages.size(), [&](size_t begin, size_t end) {
+            auto digests = Sha256::hash_many({messages.begin() + begin, messages.begin() + end});
+            for (size_t i = begin; i < end; i++) {
+                signatures[i] = sign(encode_digest(digests[i - begin]));
+            }
+        });
+        return signatures;
+    }
+
+    std::vector<bool> verify_messages(const std::vector<std::string_view>& messages, const std::vector<BigInt>& signatures) {
+        if (messages.size() != signatures.size()) {
+            throw std::invalid_argument("every message needs one signature");
+        }
 
-        return encrypted == digest;
+        std::vector<uint8_t> valid(messages.size());
+        for_each_slice(messages.size(), [&](size_t begin, size_t end) {
+            auto digests = Sha256::hash_many({messages.begin() + begin, messages.begin() + end});
+            for (size_t i = begin; i < end; i++) {
+                valid[i] = signatures[i] < public_key.n and verify(encode_digest(digests[i - begin]), signatures[i]);
+            }
+        });
+        return {valid.begin(), valid.end()};
+    }
+
+    /**
+     * @brief EMSA-PKCS1-v1_5 encoding of a SHA-256 digest (RFC 8017 9.2)
+     *
+     * 0x00 0x01 0xff .. 0xff 0x00 DigestInfo digest, as long as the modulus
+     */
+    BigInt encode_digest(const Sha256::Digest& digest) const {
+        return encode_digest(digest, public_key.n);
+    }
+
+    static BigInt encode_digest(const Sha256::Digest& digest, const BigInt& n) {
+        static constexpr std::array<uint8_t, 19> digest_info = {
+                0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01, 0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20
+        };
+
+        size_t length = (n.msb() + 7) / 8;
+        if (length < digest_info.size() + digest.size() + 11) {
+            throw std::invalid_argument("modulus too short for a SHA-256 signature");
+        }
+
+        std::vector<uint8_t> encoded(length, 0xff);
+        encoded[0] = 0x00;
+        encoded[1] = 0x01;
+        size_t info_start = length - digest.size() - digest_info.size();
+        encoded[info_start - 1] = 0x00;
+        std::copy(digest_info.begin(), digest_info.end(), encoded.begin() + info_start);
+        std::copy(digest.begin(), digest.end(), encoded.end() - digest.size());
+
+        BigInt result;
+        result.from_bytes(encoded.data(), encoded.size());
+        return result;
     }
 
     /**
      * @biref generate RSA key pair with given lenght
+     *
+     * The modulus has exactly 2 * len bits. With prime_count > 2 (multi-prime RSA) the bits are split evenly over
+     * the primes, so the primes are smaller and both key generation and the CRT private operations get cheaper.
+     *
      * @param len should be times of 4
+     * @param prime_count number of prime factors of n
      * @return [public key, private key]
      */
-    std::pair<PublicKey, PrivateKey> generate_key_pair(size_t len) {
-        BigInt p = generate_prime(len / 4);
-        BigInt q = generate_prime(len / 4);
-        BigInt n = p * q;
-        BigInt phi = (p - 1) * (q - 1);
-        BigInt e = choose_e(n);
-        BigInt d = mod_inverse(e, phi);
-        BigInt t = (e * d);
-        BigInt t2 = t % phi;
-        public_key = {n, e};
-        private_key = {p, q, n, d, phi};
+    std::pair<PublicKey, PrivateKey> generate_key_pair(size_t len, size_t prime_count = 2) {
+        return generate_key_pair(len, KeyGenOptions{.prime_count = prime_count});
+    }
+
+    /**
+     * @brief generate_key_pair that gives up when options.stop_token is triggered or options.deadline passes
+     *
+     * The prime search stops within about one primality test and `SearchCancelled` is thrown; the current
+     * keys are left unchanged then.
+     */
+    std::pair<PublicKey, PrivateKey> generate_key_pair(size_t len, const KeyGenOptions& options) {
+        size_t prime_count = options.prime_count;
+        if (prime_count < 2) {
+            throw std::invalid_argument("RSA needs at least two primes");
+        }
+
+        size_t total_hex_digits = len / 2;
+        std::vector<int> digit_counts;
+        for (size_t i = 0; i < prime_count; i++) {
+            digit_counts.push_back(static_cast<int>(total_hex_digits / prime_count + (i < total_hex_digits % prime_count ? 1 : 0)));
+        }
+
+        std::vector<BigInt> exponents = make_batch_exponents(options.batch_exponents);
+        BigInt e = exponents.empty() ? choose_e() : exponents[0];
+        auto validator = [&](const BigInt& prime, const std::vector<BigInt>& accepted) {
+            if (not accept_prime(prime, accepted, e)) return false;
+            return std::all_of(exponents.begin(), exponents.end(), [&](const BigInt& exponent) {
+                return gcd(exponent, prime - 1) == 1;
+            });
+        };
+
+        auto progress = options.progress.get();
+        auto set_phase = [&](KeyGenPhase phase) {
+            if (progress != nullptr) progress->phase.store(phase, std::memory_order_release);
+        };
+        SearchLimits limits{options.stop_token, options.deadline, progress};
+
+        // t leading one bits per prime give n >= 2^bits * (1 - 2^(-t))^prime_count >= 2^(bits - 1)
+        int top_bits = 1;
+        while (std::pow(1.0 - std::ldexp(1.0, -top_bits), static_cast<double>(prime_count)) < 0.5) top_bits++;
+
+        set_phase(KeyGenPhase::searching_primes);
+        std::vector<BigInt> primes;
+        // a prime found just below a power of two may cross it, then n has one bit too many
+        while (primes.empty() or modulus_bits(primes) != 4 * total_hex_digits) {
+            primes.clear();
+            // primes_found counts the primes of the current set, both modes count only accepted ones
+            if (progress != nullptr) progress->primes_found.store(0, std::memory_order_relaxed);
+            if (keygen_mode == KeyGenMode::concurrent) {
+                primes = PrimeGenerator<BigInt>::get_primes(digit_counts, validator, limits, top_bits);
+            } else {
+                for (int digit_count: digit_counts) {
+                    BigInt prime = PrimeGenerator<BigInt>::get_prime(digit_count, limits, top_bits);
+                    while (not validator(prime, primes)) {
+                        prime = PrimeGenerator<BigInt>::get_prime(digit_count, limits, top_bits);
+                    }
+                    primes.push_back(std::move(prime));
+                    limits.count_prime();
+                }
+            }
+        }
+
+        set_phase(KeyGenPhase::building_key);
+        private_key = make_private_key(primes, e);
+        public_key = {private_key.n, e};
+        batch_exponents = std::move(exponents);
+        select_kernels();
+        set_phase(KeyGenPhase::done);
         return {public_key, private_key};
     }
-//private:
 
-    SignedBigInt exgcd(const SignedBigInt &a, const SignedBigInt &b, SignedBigInt &x, SignedBigInt &y) {
-        if (b.abs == BigInt(0)) {
-            x = BigInt(1);
-            y = BigInt(0);
-            return a;
+    /**
+     * @brief generate_key_pair(len, options) on a thread of its own
+     *
+     * A cancelled or timed out search makes the future throw `SearchCancelled`, its threads are gone by
+     * then. The keys are also stored in this object, which must outlive the future.
+     */
+    std::future<std::pair<PublicKey, PrivateKey>> generate_key_pair_async(size_t len, KeyGenOptions options) {
+        return std::async(std::launch::async, [this, len, options = std::move(options)] {
+            return generate_key_pair(len, options);
+        });
+    }
+
+    /**
+     * @brief per-key precomputation: the `ExpModContext` of the public modulus, of n and of every prime factor
+     *
+     * Moduli of 1024 / 2048 / 3072 / 4096 bits (and CRT primes of these sizes) get the unrolled fixed-size
+     * Montgomery kernels. Built for the keys it was made from, kept until they change.
+     */
+    struct Kernels {
+        Kernels(const PublicKey& public_key, const PrivateKey& private_key)
+                : public_n(public_key.n), private_n(private_key.n), primes(private_key.primes),
+                  public_context(make_context(public_key.n)), private_context(make_context(private_key.n)) {
+            for (const auto& prime: primes) {
+                prime_contexts.push_back(make_context(prime));
+            }
+        }
+
+        [[nodiscard]] bool matches(const PublicKey& public_key, const PrivateKey& private_key) const {
+            return public_n == public_key.n and private_n == private_key.n and primes == private_key.primes;
+        }
+
+        BigInt public_n;
+        BigInt private_n;
+        std::vector<BigInt> primes;
+        /**
+         * empty for a modulus that is not odd, whose exponentiations then fail as before
+         */
+        std::optional<BigInt::ExpModContext> public_context;
+        std::optional<BigInt::ExpModContext> private_context;
+        std::vector<std::optional<BigInt::ExpModContext>> prime_contexts;
+
+    private:
+        static std::optional<BigInt::ExpModContext> make_context(const BigInt& mod) {
+            if (mod.significant_length() == 0 or not mod.bit_test(0)) return std::nullopt;
+            return std::optional<BigInt::ExpModContext>(std::in_place, mod);
+        }
+    };
+
+    /**
+     * @brief the kernels of the current keys
+     *
+     * Rebuilt on first use after `public_key` / `private_key` changed, so assigning keys directly needs no
+     * further call. Safe to call from several threads while the keys do not change.
+     */
+    std::shared_ptr<const Kernels> kernels() const {
+        auto current = kernel_cache.current.load(std::memory_order_acquire);
+        if (current != nullptr and current->matches(public_key, private_key)) {
+            return current;
+        }
+        return select_kernels();
+    }
+
+    /**
+     * @brief build the kernels of the current keys now, e.g. when a key is loaded, instead of on first use
+     */
+    std::shared_ptr<const Kernels> select_kernels() const {
+        // kept beyond the calling operation
+        HeapScope heap;
+        auto built = std::make_shared<const Kernels>(public_key, private_key);
+        kernel_cache.current.store(built, std::memory_order_release);
+        return built;
+    }
+
+    static size_t modulus_bits(const std::vector<BigInt>& primes) {
+        BigInt n = primes[0];
+        for (size_t i = 1; i < primes.size(); i++) {
+            n = n * primes[i];
         }
-        SignedBigInt x1, y1;
-        SignedBigInt gcd = exgcd(b, a % b, x1, y1);
-        x = y1;
-        y = x1 - (a / b) * y1;
-        return gcd;
+        return n.msb();
     }
 
+    /**
+     * @brief build the private key (including the CRT parameters) from the prime factors of n
+     * @param primes at least two distinct primes
+     * @param e public exponent
+     * @return
+     */
+    PrivateKey make_private_key(const std::vector<BigInt>& primes, const BigInt& e) {
+        PrivateKey key;
+        key.p = primes[0];
+        key.q = primes[1];
+        key.primes = primes;
+
+        key.n = primes[0];
+        key.phi = primes[0] - 1;
+        for (size_t i = 1; i < primes.size(); i++) {
+            key.n = key.n * primes[i];
+            key.phi = key.phi * (primes[i] - 1);
+        }
+        key.d = mod_inverse(e, key.phi);
+
+        BigInt product = primes[0];
+        key.coefficients.emplace_back(1);
+        for (size_t i = 0; i < primes.size(); i++) {
+            key.exponents.push_back(key.d % (primes[i] - 1));
+            if (i > 0) {
+                key.coefficients.push_back(mod_inverse(product % primes[i], primes[i]));
+                product = product * primes[i];
+            }
+        }
+        return key;
+    }
+//private:
+
+    /**
+     * @brief x^(-1) mod n by the iterative extended Euclidean algorithm
+     *
+     * The coefficients s_i of x in r_i = s_i * x mod n alternate in sign, so only their magnitudes
+     * t_{i+1} = t_{i-1} + q_i * t_i are kept, with one divmod per step and no recursion.
+     */
     BigInt mod_inverse(const BigInt &x, const BigInt &n) {
-        SignedBigInt sx = x, sn = n;
-        SignedBigInt x_inv, y;
-        SignedBigInt gcd = exgcd(sx, sn, x_inv, y);
+        BigInt r0 = n, r1 = x % n;
+        BigInt t0(0), t1(1);
+        bool r1_positive = true;
+        while (not r1.is_zero()) {
+            auto [q, r] = r0.divmod(r1);
+            // t_{i+1} into the storage of t_{i-1}
+            t0 += BigInt::lazy(q) * t1;
+            std::swap(t0, t1);
+            r0 = std::move(r1);
+            r1 = std::move(r);
+            r1_positive = not r1_positive;
+        }
 
-        if (not(gcd.abs == BigInt(1))) {
+        if (not (r0 == 1)) {
             throw std::invalid_argument("Inverse does not exist");
         }
-
-        return ((x_inv % n + n) % n).abs;
+        // r0 takes the sign of the coefficient r1 had before the last step
+        return r1_positive ? n - t0 : t0;
     }
 
-    BigInt choose_e(const BigInt& n) {
+    BigInt choose_e() {
         return BigInt("0x10001");
     }
 
+    static BigInt gcd(BigInt a, BigInt b) {
+        while (not b.is_zero()) {
+            a = a % b;
+            std::swap(a, b);
+        }
+        return a;
+    }
+
+    /**
+     * @brief check a new prime factor against e and the primes accepted so far
+     *
+     * gcd(e, prime - 1) = 1 is needed for d to exist. Any two primes must differ by more than
+     * 2^(bits - 100) (FIPS 186-4 B.3.1), so n cannot be factored by searching around sqrt(n).
+     */
+    static bool accept_prime(const BigInt& prime, const std::vector<BigInt>& accepted, const BigInt& e) {
+        if (not (gcd(e, prime - 1) == 1)) {
+            return false;
+        }
+
+        for (const auto& other: accepted) {
+            BigInt diff = prime >= other ? prime - other : other - prime;
+            int min_bits = std::min(prime.msb(), other.msb());
+            if (diff.is_zero() or diff.msb() <= std::max(0, min_bits - 100)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief f(begin, end) over contiguous slices of [0, count), one slice per core
+     *
+     * The slices run on the shared `TaskPool`, so its threads (and their blinding pairs) are reused across
+     * calls, and the CRT exponentiations inside a slice stay on the same thread while every core is busy.
+     */
+    template<typename F>
+    static void for_each_slice(size_t count, F&& f) {
+        // at least eight items per slice, a full set of AVX2 hashing lanes
+        constexpr size_t min_slice = 8;
+        size_t slices = std::min(TaskPool::global().size() + 1, (count + min_slice - 1) / min_slice);
+        if (slices <= 1) {
+            f(size_t{0}, count);
+            return;
+        }
+
+        size_t slice = (count + slices - 1) / slices;
+        TaskPool::global().for_each(slices, [&](size_t i) {
+            size_t begin = i * slice;
+            if (begin < count) {
+                f(begin, std::min(count, begin + slice));
+            }
+        });
+    }
+
+    /**
+     * @brief x^e mod n through the kept context of n
+     */
+    BigInt public_exp(const BigInt& x) const {
+        return public_exp(x, public_key.e);
+    }
+
+    BigInt public_exp(const BigInt& x, const BigInt& e) const {
+        auto current = kernels();
+        if (current->public_context.has_value()) {
+            return current->public_context->pow(x, e);
+        }
+        return BigInt::fast_odd_exp_mod(x, e, public_key.n);
+    }
+
+    /**
+     * @brief node of the product tree of `batch_decrypt`, covering the ciphers [begin, end)
+     */
+    struct BatchNode {
+        static constexpr size_t leaf = std::numeric_limits<size_t>::max();
+
+        size_t begin = 0;
+        size_t end = 0;
+        size_t left = leaf;
+        size_t right = leaf;
+        /**
+         * E, product of the exponents below
+         */
+        BigInt exponent;
+        /**
+         * v = prod c_i^(E / e_i) mod n
+         */
+        BigInt value;
+        /**
+         * A = prod m_i mod n, filled top down
+         */
+        BigInt message_product;
+    };
+
+    /**
+     * @brief build the subtree of [begin, end) bottom up, its root is the last node
+     * @param ciphers reduced mod n, ciphers[i] encrypted under exponents[i]
+     */
+    void batch_percolate_up(std::vector<BatchNode>& tree, const std::vector<BigInt>& ciphers, const std::vector<BigInt>& exponents,
+                            size_t begin, size_t end) const {
+        BatchNode node;
+        node.begin = begin;
+        node.end = end;
+        if (end - begin == 1) {
+            node.exponent = exponents[begin];
+            node.value = ciphers[begin];
+            tree.push_back(std::move(node));
+            return;
+        }
+
+        size_t middle = begin + (end - begin) / 2;
+        batch_percolate_up(tree, ciphers, exponents, begin, middle);
+        size_t left = tree.size() - 1;
+        batch_percolate_up(tree, ciphers, exponents, middle, end);
+        size_t right = tree.size() - 1;
+
+        // v = v_L^E_R * v_R^E_L
+        node.left = left;
+        node.right = right;
+        node.value = (public_exp(tree[left].value, tree[right].exponent) * public_exp(tree[right].value, tree[left].exponent)) % public_key.n;
+        node.exponent = tree[left].exponent * tree[right].exponent;
+        tree.push_back(std::move(node));
+    }
+
+    /**
+     * @brief d_E = E^(-1) mod (r_i - 1) for every prime r_i, the CRT exponents of an E-th root
+     */
+    std::vector<BigInt> batch_root_exponents(const BigInt& exponent) {
+        std::vector<BigInt> exponents;
+        for (const auto& prime: private_key.primes) {
+            exponents.push_back(mod_inverse(exponent % (prime - 1), prime - 1));
+        }
+        return exponents;
+    }
+
+    /**
+     * @brief whether `batch_exponents` fit the current keys: the first one is e and all are coprime to every
+     *        r_i - 1, which fails for exponents left over from other keys
+     */
+    bool batch_exponents_match_key() {
+        if (batch_exponents.empty() or not (batch_exponents[0] == public_key.e) or not (public_key.n == private_key.n)) {
+            return false;
+        }
+        return std::all_of(batch_exponents.begin(), batch_exponents.end(), [&](const BigInt& exponent) {
+            return std::all_of(private_key.primes.begin(), private_key.primes.end(), [&](const BigInt& prime) {
+                return gcd(exponent, prime - 1) == 1;
+            });
+        });
+    }
+
+    /**
+     * @brief inverses of all values mod n with a single `mod_inverse`
+     */
+    std::vector<BigInt> batch_mod_inverse(const std::vector<BigInt>& values, const BigInt& n) {
+        if (values.empty()) return {};
+
+        // prefixes[i] = values[0] * ... * values[i]
+        std::vector<BigInt> prefixes = {values[0]};
+        for (size_t i = 1; i < values.size(); i++) {
+            prefixes.push_back((prefixes.back() * values[i]) % n);
+        }
+
+        std::vector<BigInt> inverses(values.size());
+        BigInt inverse = mod_inverse(prefixes.back(), n);
+        for (size_t i = values.size(); i-- > 1;) {
+            inverses[i] = (inverse * prefixes[i - 1]) % n;
+            inverse = (inverse * values[i]) % n;
+        }
+        inverses[0] = std::move(inverse);
+        return inverses;
+    }
+
+    /**
+     * @brief check the batch exponents of `KeyGenOptions`: odd, above 1 and pairwise coprime
+     */
+    static std::vector<BigInt> make_batch_exponents(const std::vector<uint64_t>& values) {
+        std::vector<BigInt> exponents;
+        for (uint64_t value: values) {
+            BigInt exponent(value);
+            if (value < 3 or value % 2 == 0) {
+                throw std::invalid_argument("batch exponents must be odd and above 1");
+            }
+            for (const auto& other: exponents) {
+                if (not (gcd(exponent, other) == 1)) {
+                    throw std::invalid_argument("batch exponents must be pairwise coprime");
+                }
+            }
+            exponents.push_back(std::move(exponent));
+        }
+        return exponents;
+    }
+
+    /**
+     * @brief base blinding pair of one key: blind = r^e and unblind = r^(-1) mod n for a random r
+     */
+    struct BlindingPair {
+        BigInt n;
+        BigInt e;
+        BigInt blind;
+        BigInt unblind;
+    };
+
+    /**
+     * @brief the calling thread's blinding pair of the current key, made on first use
+     *
+     * Every thread keeps its own pairs, so blinding takes no lock. A pair is looked up by (n, e), which stays
+     * correct when the keys of this object change or another RSA object uses the same key.
+     */
+    BlindingPair& blinding_pair() {
+        constexpr size_t max_pairs = 16;
+        thread_local std::vector<BlindingPair> pairs;
+
+        const BigInt& n = private_key.n;
+        for (auto& pair: pairs) {
+            if (pair.n == n and pair.e == public_key.e) return pair;
+        }
+
+        // the pairs outlive the calling operation
+        HeapScope heap;
+        if (pairs.size() == max_pairs) {
+            pairs.erase(pairs.begin());
+        }
+        while (true) {
+            BigInt r = BigInt::random(n.msb() - 1, Random::local());
+            try {
+                BigInt unblind = mod_inverse(r, n);
+                pairs.push_back({n, public_key.e, public_exp(r), std::move(unblind)});
+                return pairs.back();
+            } catch (std::invalid_argument&) {
+                // r shares a factor with n, next one
+            }
+        }
+    }
+
+    /**
+     * @brief private_exp_mod on x * r^e, unblinded by r^(-1); both factors are squared for the next call
+     *
+     * Costs four modular multiplications instead of a fresh r per call (an inverse and an exponentiation).
+     * The squared factors leave the operation's arena with its result, on the heap.
+     */
+    BigInt blinded_private_exp_mod(const BigInt& x) {
+        // r^e needs the matching public key
+        if (not blinding or public_key.e.is_zero() or private_key.n.is_zero() or not (public_key.n == private_key.n)) {
+            return ArenaScope::run([&] { return private_exp_mod(x); });
+        }
+
+        const BigInt& n = private_key.n;
+        BlindingPair& pair = blinding_pair();
+        auto [result, blind, unblind] = ArenaScope::run([&] {
+            BigInt blinded_result = (private_exp_mod((x * pair.blind) % n) * pair.unblind) % n;
+            return std::tuple{std::move(blinded_result), (pair.blind * pair.blind) % n, (pair.unblind * pair.unblind) % n};
+        });
+        pair.blind = std::move(blind);
+        pair.unblind = std::move(unblind);
+        return std::move(result);
+    }
+
+    /**
+     * @brief x^d mod n, through the CRT when the prime factors are known
+     */
+    BigInt private_exp_mod(const BigInt& x) {
+        if (private_key.primes.size() < 2) {
+            auto current = kernels();
+            if (current->private_context.has_value()) {
+                return current->private_context->pow(x, private_key.d);
+            }
+            return BigInt::fast_odd_exp_mod(x, private_key.d, private_key.n);
+        }
+        return crt_exp_mod(x, private_key.exponents);
+    }
+
+    /**
+     * @brief x^d mod n given d mod (r_i - 1) for every prime factor r_i of n
+     *
+     * The prime-sized exponentiations are independent and run on idle workers of the shared `TaskPool`
+     * (sequentially when every core is busy, e.g. under a batch), then get recombined
+     * with Garner's formula m = m + (r_0 * ... * r_{i-1}) * ((m_i - m) * t_i mod r_i).
+     */
+    BigInt crt_exp_mod(const BigInt& x, const std::vector<BigInt>& exponents) {
+        const auto& primes = private_key.primes;
+        auto current = kernels();
+
+        // the exponentiations may run on pool workers; a scope opened by a pool task bump-allocates in the arena
+        // of the thread that runs it (see `TaskArenaFrame`), and its result is copied to the heap
+        auto prime_exp_mod = [&](size_t i) {
+            const auto& context = current->prime_contexts[i];
+            return ArenaScope::run([&] {
+                return context.has_value() ? context->pow(x, exponents[i]) : BigInt::fast_odd_exp_mod(x % primes[i], exponents[i], primes[i]);
+            });
+        };
+
+        std::vector<BigInt> residues(primes.size());
+        TaskPool::global().for_each(primes.size(), [&](size_t i) { residues[i] = prime_exp_mod(i); });
+
+        BigInt result = residues[0];
+        BigInt product = primes[0];
+        for (size_t i = 1; i < primes.size(); i++) {
+            BigInt reduced = result % primes[i];
+            BigInt diff = residues[i] >= reduced ? residues[i] - reduced : residues[i] + primes[i] - reduced;
+            BigInt h = (diff * private_key.coefficients[i]) % primes[i];
+            result = result + product * h;
+            if (i + 1 < primes.size()) {
+                product = product * primes[i];
+            }
+        }
+        return result;
+    }
+
     PublicKey public_key;
     PrivateKey private_key;
+
+    /**
+     * public exponents of `batch_decrypt`, batch_exponents[0] = e; empty unless the keys were generated with
+     * `KeyGenOptions::batch_exponents` or read with them. `batch_decrypt` refuses exponents that do not fit
+     * the current keys, so replace or clear them together with the keys
+     */
+    std::vector<BigInt> batch_exponents;
+
+private:
+    /**
+     * @brief holder of the current `Kernels`, copies of an RSA object share them until their keys differ
+     */
+    struct KernelCache {
+        KernelCache() = default;
+
+        KernelCache(const KernelCache& other) : current(other.current.load()) {}
+
+        KernelCache& operator=(const KernelCache& other) {
+            current.store(other.current.load());
+            return *this;
+        }
+
+        std::atomic<std::shared_ptr<const Kernels>> current;
+    };
+
+    mutable KernelCache kernel_cache;
 };
\ No newline at end of file
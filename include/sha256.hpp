@@ -0,0 +1,358 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define RSA_SHA256_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief SHA-256 (FIPS 180-4)
+ *
+ * Blocks go through the SHA extensions when the CPU has them. Without them `hash_many` runs eight
+ * messages side by side in the lanes of AVX2 registers, which is about three times the portable
+ * code but slower than SHA-NI on one message. Picked at run time.
+ */
+struct Sha256 {
+    using Digest = std::array<uint8_t, 32>;
+    using State = std::array<uint32_t, 8>;
+
+    static constexpr size_t block_size = 64;
+
+    /**
+     * use SHA-NI / AVX2 when available, false forces the portable code
+     */
+    static inline bool use_cpu_extensions = true;
+
+    void update(const void* data, size_t length) {
+        auto bytes = static_cast<const uint8_t*>(data);
+        total_length += length;
+
+        if (buffered > 0) {
+            size_t count = std::min(length, block_size - buffered);
+            std::memcpy(buffer.data() + buffered, bytes, count);
+            buffered += count;
+            bytes += count;
+            length -= count;
+            if (buffered < block_size) return;
+            compress(state, buffer.data(), 1);
+            buffered = 0;
+        }
+
+        compress(state, bytes, length / block_size);
+        bytes += length / block_size * block_size;
+        buffered = length % block_size;
+        std::memcpy(buffer.data(), bytes, buffered);
+    }
+
+    Digest finish() {
+        uint8_t tail[2 * block_size];
+        size_t tail_length = pad(buffer.data(), buffered, total_length, tail);
+        compress(state, tail, tail_length / block_size);
+        return to_digest(state);
+    }
+
+    static Digest hash(std::string_view message) {
+        Sha256 sha;
+        sha.update(message.data(), message.size());
+        return sha.finish();
+    }
+
+    /**
+     * @brief digests of all messages, eight at a time through AVX2 when there is no SHA-NI
+     */
+    static std::vector<Digest> hash_many(const std::vector<std::string_view>& messages) {
+        std::vector<Digest> digests(messages.size());
+#if defined(RSA_SHA256_X86)
+        if (use_cpu_extensions and not has_sha_ni() and has_avx2()) {
+            for (size_t i = 0; i < messages.size(); i += lanes) {
+                size_t count = std::min(lanes, messages.size() - i);
+                hash_lanes(messages.data() + i, count, digests.data() + i);
+            }
+            return digests;
+        }
+#endif
+        for (size_t i = 0; i < messages.size(); i++) {
+            digests[i] = hash(messages[i]);
+        }
+        return digests;
+    }
+
+    static constexpr std::array<uint32_t, 64> round_constants = {
+            0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+            0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+            0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+            0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+            0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+            0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+            0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+            0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+    };
+
+    static constexpr State initial_state = {
+            0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    /**
+     * @brief the blocks through the fastest kernel of the CPU
+     */
+    static void compress(State& state, const uint8_t* blocks, size_t count) {
+        if (count == 0) return;
+#if defined(RSA_SHA256_X86)
+        if (use_cpu_extensions and has_sha_ni()) {
+            compress_sha_ni(state, blocks, count);
+            return;
+        }
+#endif
+        compress_portable(state, blocks, count);
+    }
+
+    static void compress_portable(State& state, const uint8_t* blocks, size_t count) {
+        for (; count > 0; count--, blocks += block_size) {
+            uint32_t w[64];
+            for (size_t t = 0; t < 16; t++) {
+                w[t] = load_big_endian(blocks + 4 * t);
+            }
+            for (size_t t = 16; t < 64; t++) {
+                uint32_t s0 = rotr(w[t - 15], 7) ^ rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+                uint32_t s1 = rotr(w[t - 2], 17) ^ rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+                w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+            }
+
+            uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+            uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+            for (size_t t = 0; t < 64; t++) {
+                uint32_t t1 = h + (rotr(e, 6) ^ rotr(e, 11) ^ rotr(e, 25)) + ((e & f) ^ (~e & g)) + round_constants[t] + w[t];
+                uint32_t t2 = (rotr(a, 2) ^ rotr(a, 13) ^ rotr(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+                h = g;
+                g = f;
+                f = e;
+                e = d + t1;
+                d = c;
+                c = b;
+                b = a;
+                a = t1 + t2;
+            }
+
+            state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+            state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+        }
+    }
+
+#if defined(RSA_SHA256_X86)
+    static constexpr size_t lanes = 8;
+
+    static bool has_sha_ni() {
+        static const bool supported = [] {
+            unsigned eax, ebx, ecx, edx;
+            return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) and (ebx >> 29) & 1 and
+                   __builtin_cpu_supports("sse4.1");
+        }();
+        return supported;
+    }
+
+    static bool has_avx2() {
+        static const bool supported = __builtin_cpu_supports("avx2");
+        return supported;
+    }
+
+    /**
+     * @brief two rounds per sha256rnds2, the state kept as ABEF / CDGH as the instructions expect
+     */
+    __attribute__((target("sha,sse4.1")))
+    static void compress_sha_ni(State& state, const uint8_t* blocks, size_t count) {
+        const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+        __m128i dcba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[0]));
+        __m128i hgfe = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&state[4]));
+        __m128i cdab = _mm_shuffle_epi32(dcba, 0xb1);
+        __m128i efgh = _mm_shuffle_epi32(hgfe, 0x1b);
+        __m128i abef = _mm_alignr_epi8(cdab, efgh, 8);
+        __m128i cdgh = _mm_blend_epi16(efgh, cdab, 0xf0);
+
+        for (; count > 0; count--, blocks += block_size) {
+            __m128i abef_saved = abef;
+            __m128i cdgh_saved = cdgh;
+
+            __m128i message[4];
+            for (size_t i = 0; i < 4; i++) {
+                message[i] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(blocks + 16 * i)), byte_swap);
+            }
+
+            for (size_t group = 0; group < 16; group++) {
+                __m128i words = _mm_add_epi32(message[group % 4],
+                                              _mm_loadu_si128(reinterpret_cast<const __m128i*>(&round_constants[4 * group])));
+                cdgh = _mm_sha256rnds2_epu32(cdgh, abef, words);
+                abef = _mm_sha256rnds2_epu32(abef, cdgh, _mm_shuffle_epi32(words, 0x0e));
+
+                // w[t - 16] + s0(w[t - 15]) + w[t - 7] + s1(w[t - 2]) for the group four ahead
+                if (group < 12) {
+                    __m128i next = _mm_sha256msg1_epu32(message[group % 4], message[(group + 1) % 4]);
+                    next = _mm_add_epi32(next, _mm_alignr_epi8(message[(group + 3) % 4], message[(group + 2) % 4], 4));
+                    message[group % 4] = _mm_sha256msg2_epu32(next, message[(group + 3) % 4]);
+                }
+            }
+
+            abef = _mm_add_epi32(abef, abef_saved);
+            cdgh = _mm_add_epi32(cdgh, cdgh_saved);
+        }
+
+        __m128i feba = _mm_shuffle_epi32(abef, 0x1b);
+        __m128i dchg = _mm_shuffle_epi32(cdgh, 0xb1);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[0]), _mm_blend_epi16(feba, dchg, 0xf0));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(&state[4]), _mm_alignr_epi8(dchg, feba, 8));
+    }
+
+    __attribute__((target("avx2")))
+    static __m256i rotr_x8(__m256i x, int n) {
+        return _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - n));
+    }
+
+    /**
+     * @brief up to eight messages, lane i of every register belongs to message i
+     *
+     * The lanes step through their blocks together, a lane whose message has no block left keeps its
+     * state through a blend, so messages of different lengths share the registers.
+     */
+    __attribute__((target("avx2")))
+    static void hash_lanes(const std::string_view* messages, size_t count, Digest* digests) {
+        // the padded last one or two blocks of each message
+        alignas(32) uint8_t tails[lanes][2 * block_size];
+        alignas(32) int32_t block_counts[lanes] = {};
+        size_t full_blocks[lanes] = {};
+        size_t max_blocks = 0;
+        for (size_t lane = 0; lane < count; lane++) {
+            auto bytes = reinterpret_cast<const uint8_t*>(messages[lane].data());
+            full_blocks[lane] = messages[lane].size() / block_size;
+            size_t tail_length = pad(bytes + full_blocks[lane] * block_size, messages[lane].size() % block_size,
+                                     messages[lane].size(), tails[lane]);
+            block_counts[lane] = static_cast<int32_t>(full_blocks[lane] + tail_length / block_size);
+            max_blocks = std::max<size_t>(max_blocks, block_counts[lane]);
+        }
+
+        __m256i state[8];
+        for (size_t i = 0; i < 8; i++) {
+            state[i] = _mm256_set1_epi32(static_cast<int32_t>(initial_state[i]));
+        }
+        __m256i remaining = _mm256_load_si256(reinterpret_cast<const __m256i*>(block_counts));
+
+        alignas(32) uint32_t gathered[lanes];
+        for (size_t block = 0; block < max_blocks; block++) {
+            const uint8_t* pointers[lanes];
+            for (size_t lane = 0; lane < lanes; lane++) {
+                if (lane >= count or static_cast<int32_t>(block) >= block_counts[lane]) {
+                    pointers[lane] = tails[0];
+                } else if (block < full_blocks[lane]) {
+                    pointers[lane] = reinterpret_cast<const uint8_t*>(messages[lane].data()) + block * block_size;
+                } else {
+                    pointers[lane] = tails[lane] + (block - full_blocks[lane]) * block_size;
+                }
+            }
+
+            __m256i w[16];
+            for (size_t t = 0; t < 16; t++) {
+                for (size_t lane = 0; lane < lanes; lane++) {
+                    gathered[lane] = load_big_endian(pointers[lane] + 4 * t);
+                }
+                w[t] = _mm256_load_si256(reinterpret_cast<const __m256i*>(gathered));
+            }
+
+            __m256i a = state[0], b = state[1], c = state[2], d = state[3];
+            __m256i e = state[4], f = state[5], g = state[6], h = state[7];
+            for (size_t t = 0; t < 64; t++) {
+                if (t >= 16) {
+                    __m256i w15 = w[(t - 15) % 16];
+                    __m256i w2 = w[(t - 2) % 16];
+                    __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(w15, 7), rotr_x8(w15, 18)), _mm256_srli_epi32(w15, 3));
+                    __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(w2, 17), rotr_x8(w2, 19)), _mm256_srli_epi32(w2, 10));
+                    w[t % 16] = _mm256_add_epi32(_mm256_add_epi32(w[t % 16], s0), _mm256_add_epi32(w[(t - 7) % 16], s1));
+                }
+
+                __m256i sigma1 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(e, 6), rotr_x8(e, 11)), rotr_x8(e, 25));
+                __m256i choose = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+                __m256i t1 = _mm256_add_epi32(_mm256_add_epi32(h, sigma1), _mm256_add_epi32(choose, w[t % 16]));
+                t1 = _mm256_add_epi32(t1, _mm256_set1_epi32(static_cast<int32_t>(round_constants[t])));
+                __m256i sigma0 = _mm256_xor_si256(_mm256_xor_si256(rotr_x8(a, 2), rotr_x8(a, 13)), rotr_x8(a, 22));
+                __m256i majority = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+                __m256i t2 = _mm256_add_epi32(sigma0, majority);
+                h = g;
+                g = f;
+                f = e;
+                e = _mm256_add_epi32(d, t1);
+                d = c;
+                c = b;
+                b = a;
+                a = _mm256_add_epi32(t1, t2);
+            }
+
+            __m256i active = _mm256_cmpgt_epi32(remaining, _mm256_set1_epi32(static_cast<int32_t>(block)));
+            __m256i rounds[8] = {a, b, c, d, e, f, g, h};
+            for (size_t i = 0; i < 8; i++) {
+                state[i] = _mm256_blendv_epi8(state[i], _mm256_add_epi32(state[i], rounds[i]), active);
+            }
+        }
+
+        alignas(32) uint32_t words[8][lanes];
+        for (size_t i = 0; i < 8; i++) {
+            _mm256_store_si256(reinterpret_cast<__m256i*>(words[i]), state[i]);
+        }
+        for (size_t lane = 0; lane < count; lane++) {
+            State lane_state;
+            for (size_t i = 0; i < 8; i++) {
+                lane_state[i] = words[i][lane];
+            }
+            digests[lane] = to_digest(lane_state);
+        }
+    }
+#endif
+
+private:
+    /**
+     * @brief the last partial block, 0x80, zeros and the bit length
+     * @param buffer receives one or two blocks
+     * @return length of the padded tail, 64 or 128
+     */
+    static size_t pad(const uint8_t* tail, size_t tail_length, uint64_t total_length, uint8_t* buffer) {
+        size_t length = tail_length + 9 <= block_size ? block_size : 2 * block_size;
+        std::memcpy(buffer, tail, tail_length);
+        buffer[tail_length] = 0x80;
+        std::memset(buffer + tail_length + 1, 0, length - tail_length - 1);
+
+        uint64_t bits = total_length * 8;
+        for (size_t i = 0; i < 8; i++) {
+            buffer[length - 1 - i] = static_cast<uint8_t>(bits >> (8 * i));
+        }
+        return length;
+    }
+
+    static Digest to_digest(const State& state) {
+        Digest digest;
+        for (size_t i = 0; i < 8; i++) {
+            for (size_t j = 0; j < 4; j++) {
+                digest[4 * i + j] = static_cast<uint8_t>(state[i] >> (24 - 8 * j));
+            }
+        }
+        return digest;
+    }
+
+    static uint32_t load_big_endian(const uint8_t* bytes) {
+        return static_cast<uint32_t>(bytes[0]) << 24 | static_cast<uint32_t>(bytes[1]) << 16 |
+               static_cast<uint32_t>(bytes[2]) << 8 | static_cast<uint32_t>(bytes[3]);
+    }
+
+    static constexpr uint32_t rotr(uint32_t x, int n) {
+        return (x >> n) | (x << (32 - n));
+    }
+
+    State state = initial_state;
+    std::array<uint8_t, block_size> buffer{};
+    size_t buffered = 0;
+    uint64_t total_length = 0;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "rsa.hpp"
+
+/**
+ * @brief LRU cache of the per-modulus parameters of public keys, for verifying under many keys
+ *
+ * Keyed by n, an entry holds the `ExpModContext` of the modulus (Montgomery parameters, R^2 mod n and the
+ * fixed-size kernel where one applies), so repeated verifications under a key skip all per-modulus setup.
+ * The keys are spread over independently locked shards; each shard evicts its least recently used entry
+ * beyond its share of the capacity. Safe to use from many threads.
+ *
+ * @tparam IntegerType Biginteger Type
+ */
+template<typename IntegerType>
+struct VerificationCache {
+    using RSAType = RSA<IntegerType>;
+    using PublicKey = typename RSAType::PublicKey;
+    using Context = typename IntegerType::ExpModContext;
+
+    struct Metrics {
+        size_t hits = 0;
+        size_t misses = 0;
+        size_t evictions = 0;
+
+        [[nodiscard]] double hit_rate() const {
+            size_t total = hits + misses;
+            return total == 0 ? 0.0 : static_cast<double>(hits) / static_cast<double>(total);
+        }
+    };
+
+    /**
+     * @param capacity number of moduli kept over all shards
+     * @param shard_count
+     */
+    explicit VerificationCache(size_t capacity = 4096, size_t shard_count = 16)
+            : shards(std::max<size_t>(shard_count, 1)) {
+        size_t per_shard = (capacity + shards.size() - 1) / shards.size();
+        for (auto& shard: shards) {
+            shard.capacity = std::max<size_t>(per_shard, 1);
+        }
+    }
+
+    VerificationCache(const VerificationCache&) = delete;
+    VerificationCache& operator=(const VerificationCache&) = delete;
+
+    /**
+     * @brief the parameters of n, computed on a miss
+     * @param n odd modulus greater than one, `std::invalid_argument` otherwise
+     * @return stays valid after the entry is evicted
+     */
+    std::shared_ptr<const Context> context(const IntegerType& n) {
+        if (not valid_modulus(n)) {
+            throw std::invalid_argument("verification cache needs an odd modulus greater than one");
+        }
+
+        auto& shard = shards[n.hash() % shards.size()];
+        {
+            std::scoped_lock lock(shard.mutex);
+            if (auto it = shard.index.find(n); it != shard.index.end()) {
+                shard.metrics.hits++;
+                shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+                return it->second->second;
+            }
+            shard.metrics.misses++;
+        }
+
+        // built without the lock, another thread may build the same context meanwhile; the entry
+        // outlives the calling operation, so it is built on the heap
+        HeapScope heap;
+        auto built = std::make_shared<const Context>(n);
+
+        std::scoped_lock lock(shard.mutex);
+        if (auto it = shard.index.find(n); it != shard.index.end()) {
+            return it->second->second;
+        }
+        shard.entries.emplace_front(n, built);
+        shard.index.emplace(n, shard.entries.begin());
+        while (shard.entries.size() > shard.capacity) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+            shard.metrics.evictions++;
+        }
+        return built;
+    }
+
+    /**
+     * @brief same as `RSA::verify` with the public key `key`, false for a modulus no key can have
+     */
+    bool verify(const PublicKey& key, const IntegerType& digest, const IntegerType& signature) {
+        // checked before a context is built, so malformed keys never take a cache entry
+        if (not valid_modulus(key.n) or signature >= key.n) return false;
+        auto cached = context(key.n);
+        return ArenaScope::run([&] { return cached->pow(signature, key.e) == digest; });
+    }
+
+    /**
+     * @brief same as `RSA::verify_message` with the public key `key`
+     */
+    bool verify_message(const PublicKey& key, std::string_view message, const IntegerType& signature) {
+        return verify(key, RSAType::encode_digest(Sha256::hash(message), key.n), signature);
+    }
+
+    Metrics metrics() const {
+        Metrics total;
+        for (auto& shard: shards) {
+            std::scoped_lock lock(shard.mutex);
+            total.hits += shard.metrics.hits;
+            total.misses += shard.metrics.misses;
+            total.evictions += shard.metrics.evictions;
+        }
+        return total;
+    }
+
+    [[nodiscard]] size_t size() const {
+        size_t total = 0;
+        for (auto& shard: shards) {
+            std::scoped_lock lock(shard.mutex);
+            total += shard.entries.size();
+        }
+        return total;
+    }
+
+private:
+    static bool valid_modulus(const IntegerType& n) {
+        return n > IntegerType(1) and n.bit_test(0);
+    }
+
+    struct Hash {
+        size_t operator()(const IntegerType& n) const {
+            return n.hash();
+        }
+    };
+
+    using Entry = std::pair<IntegerType, std::shared_ptr<const Context>>;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        size_t capacity = 1;
+        /**
+         * most recently used first
+         */
+        std::list<Entry> entries;
+        std::unordered_map<IntegerType, typename std::list<Entry>::iterator, Hash> index;
+        Metrics metrics;
+    };
+
+    std::vector<Shard> shards;
+};
@@ -1,7 +1,9 @@
 #include <pybind11/detail/common.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <chrono>
 #include <iostream>
+#include <optional>
 #include "integer/integer.hpp"
 #include "rsa.hpp"
 
@@ -14,6 +16,13 @@ PYBIND11_MODULE(rsa_py, variable)
 
     using RSA = RSA<BigInt>;
 
+    // a RuntimeError subclass, so callers can tell a cancelled / timed out search from other failures
+    py::register_exception<SearchCancelled>(variable, "SearchCancelled", PyExc_RuntimeError);
+
+    py::enum_<KeyGenMode>(variable, "KeyGenMode")
+            .value("sequential", KeyGenMode::sequential)
+            .value("concurrent", KeyGenMode::concurrent);
+
     py::class_<RSA::PublicKey>(variable, "PublicKey")
             .def_readonly("n", &RSA::PublicKey::n)
             .def_readonly("e", &RSA::PublicKey::e);
@@ -24,10 +33,14 @@ PYBIND11_MODULE(rsa_py, variable)
             .def_readonly("q", &RSA::PrivateKey::q)
             .def_readonly("n", &RSA::PrivateKey::n)
             .def_readonly("d", &RSA::PrivateKey::d)
-            .def_readonly("phi", &RSA::PrivateKey::phi);
+            .def_readonly("phi", &RSA::PrivateKey::phi)
+            .def_readonly("primes", &RSA::PrivateKey::primes)
+            .def_readonly("exponents", &RSA::PrivateKey::exponents)
+            .def_readonly("coefficients", &RSA::PrivateKey::coefficients);
 
     py::class_<RSA>(variable, "RSA")
         .def(py::init<>())
+            .def_readwrite("keygen_mode", &RSA::keygen_mode)
             .def("generate_prime", &RSA::generate_prime, py::arg("hex_bit_count"),
                  "Generate a prime number with the given bit length")
             .def("encrypt", &RSA::encrypt, py::arg("message"),
@@ -38,6 +51,24 @@ PYBIND11_MODULE(rsa_py, variable)
                  "Sign a digest using the private key")
             .def("verify", &RSA::verify, py::arg("digest"), py::arg("signature"),
                  "Verify a signature for a given digest")
-            .def("generate_key_pair", &RSA::generate_key_pair, py::arg("len"),
-                 "Generate an RSA key pair of the specified bit length");
+            .def("sign_message", &RSA::sign_message, py::arg("message"),
+                 "Hash a message with SHA-256 and sign it (PKCS#1 v1.5)")
+            .def("verify_message", &RSA::verify_message, py::arg("message"), py::arg("signature"),
+                 "Verify a PKCS#1 v1.5 SHA-256 signature of a message")
+            .def("sign_messages", &RSA::sign_messages, py::arg("messages"),
+                 "sign_message for a list of messages in one call")
+            .def("verify_messages", &RSA::verify_messages, py::arg("messages"), py::arg("signatures"),
+                 "verify_message for lists of messages and signatures in one call")
+            .def("generate_key_pair",
+                 [](RSA& rsa, size_t len, size_t prime_count, std::optional<double> timeout) {
+                     KeyGenOptions options{.prime_count = prime_count};
+                     if (timeout.has_value()) {
+                         options.deadline = std::chrono::steady_clock::now() +
+                                 std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(*timeout));
+                     }
+                     return rsa.generate_key_pair(len, options);
+                 },
+                 py::arg("len"), py::arg("prime_count") = 2, py::arg("timeout") = py::none(),
+                 py::call_guard<py::gil_scoped_release>(),
+                 "Generate an RSA key pair of the specified bit length, raises SearchCancelled after timeout seconds");
 }
\ No newline at end of file
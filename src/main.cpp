@@ -1,7 +1,400 @@
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "spdlog/spdlog.h"
 
 #include "integer/integer.hpp"
+#include "key_file.hpp"
+#include "rsa.hpp"
+
+/**
+ * @brief bulk RSA over files of fixed-size records
+ *
+ * The input file is memory mapped and cut into chunks of records. Worker threads compute chunks in
+ * parallel while the main thread writes finished chunks in input order. At most `2 * threads` chunks
+ * are in flight, so memory stays bounded however large the input is.
+ */
+
+namespace {
+
+constexpr const char* usage = R"(usage:
+  rsa_cli keygen <len> <key-file> [prime-count]
+  rsa_cli sign    --key <key-file> --in <digests>     --out <signatures> [--record-size 32, below k]
+  rsa_cli verify  --key <key-file> --in <signatures>  --digests <digests> --out <results> [--record-size 32]
+  rsa_cli encrypt --key <key-file> --in <plain>       --out <cipher>     [--record-size k-1, below k]
+  rsa_cli decrypt --key <key-file> --in <cipher>      --out <plain>      [--record-size k-1]
+
+  common options: [--threads <n>] [--chunk-records <n>]
+
+  k is the modulus size in bytes; signatures and cipher blocks are k-byte big-endian records,
+  verify writes one byte (1 valid, 0 invalid) per record.
+)";
+
+struct MappedFile {
+    explicit MappedFile(const std::string& path) {
+        fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0) {
+            ::close(fd);
+            throw std::runtime_error("cannot stat " + path);
+        }
+        size = static_cast<size_t>(st.st_size);
+
+        if (size > 0) {
+            void* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                throw std::runtime_error("cannot mmap " + path);
+            }
+            ::madvise(mapped, size, MADV_SEQUENTIAL);
+            data = static_cast<const uint8_t*>(mapped);
+        }
+    }
+
+    ~MappedFile() {
+        if (data != nullptr) ::munmap(const_cast<uint8_t*>(data), size);
+        if (fd >= 0) ::close(fd);
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    int fd = -1;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+};
+
+struct OutputFile {
+    explicit OutputFile(const std::string& path) {
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+    }
+
+    ~OutputFile() {
+        if (fd >= 0) ::close(fd);
+    }
+
+    OutputFile(const OutputFile&) = delete;
+    OutputFile& operator=(const OutputFile&) = delete;
+
+    void write(const uint8_t* bytes, size_t length) const {
+        while (length > 0) {
+            ssize_t written = ::write(fd, bytes, length);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                throw std::runtime_error("write failed");
+            }
+            bytes += written;
+            length -= static_cast<size_t>(written);
+        }
+    }
+
+    int fd = -1;
+};
+
+/**
+ * @brief one record transformation, `compute(index, input, output)` must be thread safe
+ */
+struct Operation {
+    size_t input_record = 0;
+    size_t output_record = 0;
+    std::function<void(size_t, const uint8_t*, uint8_t*)> compute;
+};
+
+/**
+ * @brief run `operation` over every record of `input`, writing results to `output` in order
+ * @return number of records processed
+ */
+size_t run_pipeline(const MappedFile& input, const Operation& operation, const OutputFile& output,
+                    size_t threads, size_t chunk_records) {
+    if (input.size % operation.input_record != 0) {
+        throw std::runtime_error("input size is not a multiple of the record size");
+    }
+
+    size_t records = input.size / operation.input_record;
+    size_t chunks = (records + chunk_records - 1) / chunk_records;
+    size_t window = 2 * threads;
+
+    struct Slot {
+        std::vector<uint8_t> buffer;
+        size_t chunk = 0;
+        size_t length = 0;
+        bool ready = false;
+    };
+    std::vector<Slot> slots(window);
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t next_claim = 0;
+    size_t next_write = 0;
+    bool aborted = false;
+    std::exception_ptr error;
+
+    auto worker = [&] {
+        while (true) {
+            size_t chunk;
+            {
+                std::unique_lock lock(mutex);
+                cv.wait(lock, [&] { return aborted or next_claim >= chunks or next_claim < next_write + window; });
+                if (aborted or next_claim >= chunks) return;
+                chunk = next_claim++;
+            }
+
+            Slot& slot = slots[chunk % window];
+            size_t begin = chunk * chunk_records;
+            size_t end = std::min(records, begin + chunk_records);
+            slot.buffer.resize((end - begin) * operation.output_record);
+
+            try {
+                for (size_t i = begin; i < end; i++) {
+                    operation.compute(i, input.data + i * operation.input_record,
+                                      slot.buffer.data() + (i - begin) * operation.output_record);
+                }
+            } catch (...) {
+                std::scoped_lock lock(mutex);
+                if (not error) error = std::current_exception();
+                aborted = true;
+                cv.notify_all();
+                return;
+            }
+
+            {
+                std::scoped_lock lock(mutex);
+                slot.chunk = chunk;
+                slot.length = slot.buffer.size();
+                slot.ready = true;
+            }
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::jthread> workers;
+    for (size_t i = 0; i < threads; i++) {
+        workers.emplace_back(worker);
+    }
+
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        Slot& slot = slots[chunk % window];
+        {
+            std::unique_lock lock(mutex);
+            cv.wait(lock, [&] { return aborted or (slot.ready and slot.chunk == chunk); });
+            if (aborted) break;
+        }
+
+        try {
+            output.write(slot.buffer.data(), slot.length);
+        } catch (...) {
+            std::scoped_lock lock(mutex);
+            if (not error) error = std::current_exception();
+            aborted = true;
+            cv.notify_all();
+            break;
+        }
+
+        {
+            std::scoped_lock lock(mutex);
+            slot.ready = false;
+            next_write++;
+        }
+        cv.notify_all();
+    }
+
+    for (auto& t: workers) {
+        t.join();
+    }
+
+    if (error) std::rethrow_exception(error);
+    return records;
+}
+
+std::map<std::string, std::string> parse_options(int argc, char* argv[], int first) {
+    std::map<std::string, std::string> options;
+    for (int i = first; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.rfind("--", 0) != 0 or i + 1 >= argc) {
+            throw std::invalid_argument("unexpected argument " + arg);
+        }
+        options[arg.substr(2)] = argv[++i];
+    }
+    return options;
+}
+
+size_t parse_size(const std::string& value) {
+    size_t result = 0;
+    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), result);
+    if (ec != std::errc() or ptr != value.data() + value.size()) {
+        throw std::invalid_argument("not a number: " + value);
+    }
+    return result;
+}
+
+std::string require(const std::map<std::string, std::string>& options, const std::string& name) {
+    auto it = options.find(name);
+    if (it == options.end()) {
+        throw std::invalid_argument("missing --" + name);
+    }
+    return it->second;
+}
+
+size_t get_size(const std::map<std::string, std::string>& options, const std::string& name, size_t default_value) {
+    auto it = options.find(name);
+    return it == options.end() ? default_value : parse_size(it->second);
+}
+
+void save_key(const std::string& path, const RSA<BigInt>& rsa) {
+    std::ofstream file(path);
+    if (not file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    write_key(file, rsa);
+}
+
+/**
+ * @return whether the key file contains the private exponent
+ */
+bool load_key(const std::string& path, RSA<BigInt>& rsa) {
+    std::ifstream file(path);
+    if (not file) {
+        throw std::runtime_error("cannot open " + path);
+    }
+    return read_key(file, rsa);
+}
+
+int keygen(int argc, char* argv[]) {
+    if (argc != 4 and argc != 5) {
+        throw std::invalid_argument("keygen needs <len> <key-file> [prime-count]");
+    }
+    RSA<BigInt> rsa;
+    rsa.generate_key_pair(parse_size(argv[2]), argc == 5 ? parse_size(argv[4]) : 2);
+    save_key(argv[3], rsa);
+    return 0;
+}
+
+int bulk(const std::string& command, int argc, char* argv[]) {
+    auto options = parse_options(argc, argv, 2);
+
+    RSA<BigInt> rsa;
+    bool has_private = load_key(require(options, "key"), rsa);
+    size_t k = (rsa.public_key.n.msb() + 7) / 8;
+
+    bool needs_private = command == "sign" or command == "decrypt";
+    if (needs_private and not has_private) {
+        throw std::invalid_argument(command + " needs the private exponent d in the key file");
+    }
+
+    size_t threads = get_size(options, "threads", std::max(1u, std::thread::hardware_concurrency()));
+    size_t chunk_records = get_size(options, "chunk-records", 256);
+    if (threads == 0 or chunk_records == 0) {
+        throw std::invalid_argument("--threads and --chunk-records must be positive");
+    }
+
+    MappedFile input(require(options, "in"));
+    std::unique_ptr<MappedFile> digests;
+    Operation operation;
+
+    if (command == "sign") {
+        operation.input_record = get_size(options, "record-size", 32);
+        operation.output_record = k;
+        operation.compute = [&](size_t, const uint8_t* in, uint8_t* out) {
+            BigInt digest;
+            digest.from_bytes(in, operation.input_record);
+            rsa.sign(digest).to_bytes(out, k);
+        };
+    } else if (command == "verify") {
+        size_t digest_size = get_size(options, "record-size", 32);
+        digests = std::make_unique<MappedFile>(require(options, "digests"));
+        if (digests->size != input.size / k * digest_size) {
+            throw std::invalid_argument("digest file does not match the signature file");
+        }
+        operation.input_record = k;
+        operation.output_record = 1;
+        operation.compute = [&, digest_size](size_t index, const uint8_t* in, uint8_t* out) {
+            BigInt signature, digest;
+            signature.from_bytes(in, k);
+            digest.from_bytes(digests->data + index * digest_size, digest_size);
+            out[0] = rsa.verify(digest, signature) ? 1 : 0;
+        };
+    } else if (command == "encrypt") {
+        operation.input_record = get_size(options, "record-size", k - 1);
+        operation.output_record = k;
+        operation.compute = [&](size_t, const uint8_t* in, uint8_t* out) {
+            BigInt message;
+            message.from_bytes(in, operation.input_record);
+            rsa.encrypt(message).to_bytes(out, k);
+        };
+    } else if (command == "decrypt") {
+        operation.input_record = k;
+        operation.output_record = get_size(options, "record-size", k - 1);
+        operation.compute = [&](size_t, const uint8_t* in, uint8_t* out) {
+            BigInt cipher;
+            cipher.from_bytes(in, k);
+            rsa.decrypt(cipher).to_bytes(out, operation.output_record);
+        };
+    }
+
+    if (operation.input_record == 0 or operation.output_record == 0) {
+        throw std::invalid_argument("--record-size must be positive");
+    }
+    // a record of k bytes may be n or more, it would be reduced mod n and could never be recovered or verified
+    if ((command == "sign" or command == "encrypt") and operation.input_record >= k) {
+        throw std::invalid_argument("--record-size must be below the modulus size of " + std::to_string(k) + " bytes");
+    }
+
+    OutputFile output(require(options, "out"));
+
+    auto start = std::chrono::steady_clock::now();
+    size_t records = run_pipeline(input, operation, output, threads, chunk_records);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    spdlog::info("{}: {} records in {:.3f}s, {:.1f} records/sec ({} threads)", command, records, seconds,
+                 seconds > 0 ? static_cast<double>(records) / seconds : 0.0, threads);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::cerr << usage;
+        return 1;
+    }
 
-int main() {
-    std::cout << "test" << std::endl;
+    std::string command = argv[1];
+    try {
+        if (command == "keygen") {
+            return keygen(argc, argv);
+        }
+        if (command == "sign" or command == "verify" or command == "encrypt" or command == "decrypt") {
+            return bulk(command, argc, argv);
+        }
+        throw std::invalid_argument("unknown command " + command);
+    } catch (std::exception& e) {
+        spdlog::error(e.what());
+        std::cerr << usage;
+        return 1;
+    }
 }
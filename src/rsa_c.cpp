@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+#include "integer/integer.hpp"
+#include "key_file.hpp"
+#include "rsa.h"
+#include "rsa.hpp"
+
+/**
+ * @brief librsa, the C API of include/rsa.h over `RSA<BigInt>`
+ *
+ * No exception leaves the library: every entry point maps it to an `rsa_status`.
+ */
+
+struct rsa_key {
+    /**
+     * never changed after the handle is made; the operations are not const only because blinding updates
+     * the calling thread's own pair, so sharing the handle between threads is safe
+     */
+    mutable RSA<BigInt> rsa;
+    bool has_private = false;
+    size_t modulus_bytes = 0;
+};
+
+namespace {
+
+struct Error {
+    rsa_status status;
+};
+
+template<typename F>
+rsa_status guard(F&& f) noexcept {
+    try {
+        f();
+        return RSA_OK;
+    } catch (const Error& e) {
+        return e.status;
+    } catch (const std::invalid_argument&) {
+        return RSA_ERROR_INVALID_ARGUMENT;
+    } catch (const std::bad_alloc&) {
+        return RSA_ERROR_OUT_OF_MEMORY;
+    } catch (...) {
+        return RSA_ERROR_INTERNAL;
+    }
+}
+
+void require(bool condition, rsa_status status = RSA_ERROR_INVALID_ARGUMENT) {
+    if (not condition) throw Error{status};
+}
+
+const rsa_key& check_key(const rsa_key* key, bool needs_private) {
+    require(key != nullptr);
+    require(not needs_private or key->has_private, RSA_ERROR_NO_PRIVATE_KEY);
+    return *key;
+}
+
+rsa_key* make_key(RSA<BigInt>&& rsa, bool has_private) {
+    const BigInt& n = rsa.public_key.n;
+    require(n.bit_test(0) and n.msb() > 1);
+    size_t modulus_bytes = (n.msb() + 7) / 8;
+    return new rsa_key{std::move(rsa), has_private, modulus_bytes};
+}
+
+BigInt read_input(const rsa_key& key, const uint8_t* bytes, size_t length) {
+    BigInt value;
+    value.from_bytes(bytes, length);
+    require(value < key.rsa.public_key.n, RSA_ERROR_OUT_OF_RANGE);
+    return value;
+}
+
+void write_output(const BigInt& value, uint8_t* bytes, size_t length) {
+    require(value.is_zero() or (static_cast<size_t>(value.msb()) + 7) / 8 <= length, RSA_ERROR_BUFFER_TOO_SMALL);
+    value.to_bytes(bytes, length);
+}
+
+void sign_one(const rsa_key& key, const uint8_t* digest, size_t digest_length, uint8_t* signature, size_t signature_length) {
+    write_output(key.rsa.sign(read_input(key, digest, digest_length)), signature, signature_length);
+}
+
+bool verify_one(const rsa_key& key, const uint8_t* digest, size_t digest_length, const uint8_t* signature,
+                size_t signature_length) {
+    BigInt expected, value;
+    expected.from_bytes(digest, digest_length);
+    value.from_bytes(signature, signature_length);
+    return value < key.rsa.public_key.n and key.rsa.verify(expected, value);
+}
+
+void encrypt_one(const rsa_key& key, const uint8_t* message, size_t message_length, uint8_t* cipher, size_t cipher_length) {
+    write_output(key.rsa.encrypt(read_input(key, message, message_length)), cipher, cipher_length);
+}
+
+void decrypt_one(const rsa_key& key, const uint8_t* cipher, size_t cipher_length, uint8_t* message, size_t message_length) {
+    write_output(key.rsa.decrypt(read_input(key, cipher, cipher_length)), message, message_length);
+}
+
+/**
+ * @brief check the record layout of a batch and run f(index) for every record, in slices on the shared
+ *        `TaskPool` (see `RSA::for_each_slice`)
+ */
+template<typename F>
+void for_each_record(size_t count, bool has_records, F&& f) {
+    if (count == 0) return;
+    require(has_records);
+    RSA<BigInt>::for_each_slice(count, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            f(i);
+        }
+    });
+}
+
+} // namespace
+
+extern "C" {
+
+const char* rsa_status_string(rsa_status status) {
+    switch (status) {
+        case RSA_OK: return "ok";
+        case RSA_ERROR_INVALID_ARGUMENT: return "invalid argument";
+        case RSA_ERROR_BUFFER_TOO_SMALL: return "output buffer too small";
+        case RSA_ERROR_OUT_OF_RANGE: return "input not less than the modulus";
+        case RSA_ERROR_NO_PRIVATE_KEY: return "key has no private exponent";
+        case RSA_ERROR_OUT_OF_MEMORY: return "out of memory";
+        case RSA_ERROR_INTERNAL: return "internal error";
+    }
+    return "unknown status";
+}
+
+rsa_status rsa_key_generate(size_t bits, size_t prime_count, rsa_key** key) {
+    return guard([&] {
+        require(key != nullptr and bits >= 64 and bits % 8 == 0 and prime_count >= 2);
+        RSA<BigInt> rsa;
+        // generate_key_pair takes half the modulus size
+        rsa.generate_key_pair(bits / 2, prime_count);
+        *key = make_key(std::move(rsa), true);
+    });
+}
+
+rsa_status rsa_key_load(const uint8_t* data, size_t length, rsa_key** key) {
+    return guard([&] {
+        require(data != nullptr and key != nullptr);
+        std::istringstream in(std::string(reinterpret_cast<const char*>(data), length));
+        RSA<BigInt> rsa;
+        bool has_private = read_key(in, rsa);
+        *key = make_key(std::move(rsa), has_private);
+    });
+}
+
+rsa_status rsa_public_key_load(const uint8_t* n, size_t n_length, const uint8_t* e, size_t e_length, rsa_key** key) {
+    return guard([&] {
+        require(n != nullptr and e != nullptr and key != nullptr);
+        RSA<BigInt> rsa;
+        rsa.public_key.n.from_bytes(n, n_length);
+        rsa.public_key.e.from_bytes(e, e_length);
+        require(not rsa.public_key.e.is_zero());
+        rsa.private_key.n = rsa.public_key.n;
+        rsa.select_kernels();
+        *key = make_key(std::move(rsa), false);
+    });
+}
+
+rsa_status rsa_key_store(const rsa_key* key, int include_private, uint8_t* data, size_t* length) {
+    return guard([&] {
+        require(key != nullptr and length != nullptr);
+        std::ostringstream out;
+        write_key(out, key->rsa, include_private != 0);
+        std::string text = std::move(out).str();
+
+        size_t capacity = *length;
+        *length = text.size();
+        require(data != nullptr and text.size() <= capacity, RSA_ERROR_BUFFER_TOO_SMALL);
+        std::copy(text.begin(), text.end(), data);
+    });
+}
+
+rsa_status rsa_public_key_store(const rsa_key* key, uint8_t* n, size_t n_length, uint8_t* e, size_t e_length) {
+    return guard([&] {
+        require(key != nullptr and n != nullptr and e != nullptr);
+        write_output(key->rsa.public_key.n, n, n_length);
+        write_output(key->rsa.public_key.e, e, e_length);
+    });
+}
+
+void rsa_key_free(rsa_key* key) {
+    delete key;
+}
+
+size_t rsa_key_modulus_bytes(const rsa_key* key) {
+    return key == nullptr ? 0 : key->modulus_bytes;
+}
+
+int rsa_key_has_private(const rsa_key* key) {
+    return key != nullptr and key->has_private ? 1 : 0;
+}
+
+rsa_status rsa_sign(const rsa_key* key, const uint8_t* digest, size_t digest_length,
+                    uint8_t* signature, size_t signature_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, true);
+        require(digest != nullptr and signature != nullptr);
+        require(signature_length >= k.modulus_bytes, RSA_ERROR_BUFFER_TOO_SMALL);
+        sign_one(k, digest, digest_length, signature, signature_length);
+    });
+}
+
+rsa_status rsa_verify(const rsa_key* key, const uint8_t* digest, size_t digest_length,
+                      const uint8_t* signature, size_t signature_length, int* valid) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, false);
+        require(digest != nullptr and signature != nullptr and valid != nullptr);
+        *valid = verify_one(k, digest, digest_length, signature, signature_length) ? 1 : 0;
+    });
+}
+
+rsa_status rsa_encrypt(const rsa_key* key, const uint8_t* message, size_t message_length,
+                       uint8_t* cipher, size_t cipher_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, false);
+        require(message != nullptr and cipher != nullptr);
+        require(cipher_length >= k.modulus_bytes, RSA_ERROR_BUFFER_TOO_SMALL);
+        encrypt_one(k, message, message_length, cipher, cipher_length);
+    });
+}
+
+rsa_status rsa_decrypt(const rsa_key* key, const uint8_t* cipher, size_t cipher_length,
+                       uint8_t* message, size_t message_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, true);
+        require(cipher != nullptr and message != nullptr);
+        decrypt_one(k, cipher, cipher_length, message, message_length);
+    });
+}
+
+rsa_status rsa_sign_batch(const rsa_key* key, size_t count, const uint8_t* digests, size_t digest_length,
+                          uint8_t* signatures, size_t signature_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, true);
+        require(signature_length >= k.modulus_bytes, RSA_ERROR_BUFFER_TOO_SMALL);
+        for_each_record(count, digests != nullptr and signatures != nullptr, [&](size_t i) {
+            sign_one(k, digests + i * digest_length, digest_length, signatures + i * signature_length, signature_length);
+        });
+    });
+}
+
+rsa_status rsa_verify_batch(const rsa_key* key, size_t count, const uint8_t* digests, size_t digest_length,
+                            const uint8_t* signatures, size_t signature_length, uint8_t* valid) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, false);
+        for_each_record(count, digests != nullptr and signatures != nullptr and valid != nullptr, [&](size_t i) {
+            valid[i] = verify_one(k, digests + i * digest_length, digest_length,
+                                  signatures + i * signature_length, signature_length) ? 1 : 0;
+        });
+    });
+}
+
+rsa_status rsa_encrypt_batch(const rsa_key* key, size_t count, const uint8_t* messages, size_t message_length,
+                             uint8_t* ciphers, size_t cipher_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, false);
+        require(cipher_length >= k.modulus_bytes, RSA_ERROR_BUFFER_TOO_SMALL);
+        for_each_record(count, messages != nullptr and ciphers != nullptr, [&](size_t i) {
+            encrypt_one(k, messages + i * message_length, message_length, ciphers + i * cipher_length, cipher_length);
+        });
+    });
+}
+
+rsa_status rsa_decrypt_batch(const rsa_key* key, size_t count, const uint8_t* ciphers, size_t cipher_length,
+                             uint8_t* messages, size_t message_length) {
+    return guard([&] {
+        const rsa_key& k = check_key(key, true);
+        for_each_record(count, ciphers != nullptr and messages != nullptr, [&](size_t i) {
+            decrypt_one(k, ciphers + i * cipher_length, cipher_length, messages + i * message_length, message_length);
+        });
+    });
+}
+
+} // extern "C"
@@ -0,0 +1,133 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+#include "rsa.h"
+
+TEST(CApiTest, SingleOperationsTest) {
+    rsa_key* key = nullptr;
+    ASSERT_EQ(rsa_key_generate(1024, 2, &key), RSA_OK);
+    size_t k = rsa_key_modulus_bytes(key);
+    EXPECT_EQ(k, 128);
+    EXPECT_EQ(rsa_key_has_private(key), 1);
+
+    std::vector<uint8_t> digest(32, 0x5a), signature(k);
+    ASSERT_EQ(rsa_sign(key, digest.data(), digest.size(), signature.data(), signature.size()), RSA_OK);
+    int valid = 0;
+    ASSERT_EQ(rsa_verify(key, digest.data(), digest.size(), signature.data(), signature.size(), &valid), RSA_OK);
+    EXPECT_EQ(valid, 1);
+    digest[0] ^= 1;
+    ASSERT_EQ(rsa_verify(key, digest.data(), digest.size(), signature.data(), signature.size(), &valid), RSA_OK);
+    EXPECT_EQ(valid, 0);
+
+    std::vector<uint8_t> message(k - 1, 0x33), cipher(k), plain(k - 1);
+    ASSERT_EQ(rsa_encrypt(key, message.data(), message.size(), cipher.data(), cipher.size()), RSA_OK);
+    ASSERT_EQ(rsa_decrypt(key, cipher.data(), cipher.size(), plain.data(), plain.size()), RSA_OK);
+    EXPECT_EQ(plain, message);
+
+    // errors come back as status codes
+    EXPECT_EQ(rsa_sign(key, digest.data(), digest.size(), signature.data(), k - 1), RSA_ERROR_BUFFER_TOO_SMALL);
+    EXPECT_EQ(rsa_decrypt(key, cipher.data(), cipher.size(), plain.data(), 4), RSA_ERROR_BUFFER_TOO_SMALL);
+    std::vector<uint8_t> too_large(k, 0xff);
+    EXPECT_EQ(rsa_encrypt(key, too_large.data(), k, cipher.data(), k), RSA_ERROR_OUT_OF_RANGE);
+    EXPECT_EQ(rsa_sign(nullptr, digest.data(), digest.size(), signature.data(), k), RSA_ERROR_INVALID_ARGUMENT);
+    EXPECT_EQ(rsa_key_generate(1024, 1, &key), RSA_ERROR_INVALID_ARGUMENT);
+    rsa_key_free(key);
+}
+
+TEST(CApiTest, KeyStoreLoadTest) {
+    rsa_key* key = nullptr;
+    ASSERT_EQ(rsa_key_generate(512, 3, &key), RSA_OK);
+    size_t k = rsa_key_modulus_bytes(key);
+    EXPECT_EQ(k, 64);
+
+    size_t length = 0;
+    ASSERT_EQ(rsa_key_store(key, 1, nullptr, &length), RSA_ERROR_BUFFER_TOO_SMALL);
+    std::vector<uint8_t> stored(length);
+    ASSERT_EQ(rsa_key_store(key, 1, stored.data(), &length), RSA_OK);
+    EXPECT_EQ(length, stored.size());
+
+    size_t public_length = stored.size();
+    std::vector<uint8_t> stored_public(public_length);
+    ASSERT_EQ(rsa_key_store(key, 0, stored_public.data(), &public_length), RSA_OK);
+    EXPECT_LT(public_length, stored.size());
+
+    rsa_key* loaded = nullptr;
+    rsa_key* loaded_public = nullptr;
+    ASSERT_EQ(rsa_key_load(stored.data(), stored.size(), &loaded), RSA_OK);
+    ASSERT_EQ(rsa_key_load(stored_public.data(), public_length, &loaded_public), RSA_OK);
+    EXPECT_EQ(rsa_key_has_private(loaded), 1);
+    EXPECT_EQ(rsa_key_has_private(loaded_public), 0);
+
+    std::vector<uint8_t> digest(20, 0x42), signature(k);
+    ASSERT_EQ(rsa_sign(loaded, digest.data(), digest.size(), signature.data(), k), RSA_OK);
+    int valid = 0;
+    ASSERT_EQ(rsa_verify(key, digest.data(), digest.size(), signature.data(), k, &valid), RSA_OK);
+    EXPECT_EQ(valid, 1);
+    EXPECT_EQ(rsa_sign(loaded_public, digest.data(), digest.size(), signature.data(), k), RSA_ERROR_NO_PRIVATE_KEY);
+
+    // the same public key from raw n and e
+    std::vector<uint8_t> n(k), e(4);
+    ASSERT_EQ(rsa_public_key_store(key, n.data(), n.size(), e.data(), e.size()), RSA_OK);
+    EXPECT_EQ(rsa_public_key_store(key, n.data(), k - 1, e.data(), e.size()), RSA_ERROR_BUFFER_TOO_SMALL);
+    rsa_key* raw = nullptr;
+    ASSERT_EQ(rsa_public_key_load(n.data(), n.size(), e.data(), e.size(), &raw), RSA_OK);
+    ASSERT_EQ(rsa_verify(raw, digest.data(), digest.size(), signature.data(), k, &valid), RSA_OK);
+    EXPECT_EQ(valid, 1);
+    rsa_key_free(raw);
+
+    const char even_modulus[] = "n=0x10\ne=0x3\n";
+    EXPECT_EQ(rsa_key_load(reinterpret_cast<const uint8_t*>(even_modulus), sizeof(even_modulus) - 1, &raw),
+              RSA_ERROR_INVALID_ARGUMENT);
+    const char no_exponent[] = "n=0x11\n";
+    EXPECT_EQ(rsa_key_load(reinterpret_cast<const uint8_t*>(no_exponent), sizeof(no_exponent) - 1, &raw),
+              RSA_ERROR_INVALID_ARGUMENT);
+
+    rsa_key_free(loaded);
+    rsa_key_free(loaded_public);
+    rsa_key_free(key);
+}
+
+TEST(CApiTest, BatchTest) {
+    rsa_key* key = nullptr;
+    ASSERT_EQ(rsa_key_generate(1024, 2, &key), RSA_OK);
+    size_t k = rsa_key_modulus_bytes(key);
+
+    constexpr size_t count = 20, digest_size = 32;
+    std::vector<uint8_t> digests(count * digest_size), signatures(count * k), valid(count);
+    for (size_t i = 0; i < digests.size(); i++) digests[i] = static_cast<uint8_t>(i * 7);
+
+    ASSERT_EQ(rsa_sign_batch(key, count, digests.data(), digest_size, signatures.data(), k), RSA_OK);
+    signatures[3 * k + 5] ^= 1;
+    ASSERT_EQ(rsa_verify_batch(key, count, digests.data(), digest_size, signatures.data(), k, valid.data()), RSA_OK);
+    for (size_t i = 0; i < count; i++) {
+        EXPECT_EQ(valid[i], i == 3 ? 0 : 1);
+    }
+
+    std::vector<uint8_t> ciphers(count * k), plain(digests.size());
+    ASSERT_EQ(rsa_encrypt_batch(key, count, digests.data(), digest_size, ciphers.data(), k), RSA_OK);
+    ASSERT_EQ(rsa_decrypt_batch(key, count, ciphers.data(), k, plain.data(), digest_size), RSA_OK);
+    EXPECT_EQ(plain, digests);
+    EXPECT_EQ(rsa_sign_batch(key, 0, nullptr, digest_size, nullptr, k), RSA_OK);
+
+    // one handle shared by several threads
+    std::vector<std::thread> threads;
+    std::vector<int> results(4);
+    for (size_t t = 0; t < results.size(); t++) {
+        threads.emplace_back([&, t] {
+            std::vector<uint8_t> signature(k);
+            int ok = 1;
+            for (size_t i = 0; i < count; i++) {
+                int v = 0;
+                const uint8_t* digest = digests.data() + i * digest_size;
+                ok &= rsa_sign(key, digest, digest_size, signature.data(), k) == RSA_OK;
+                ok &= rsa_verify(key, digest, digest_size, signature.data(), k, &v) == RSA_OK and v == 1;
+            }
+            results[t] = ok;
+        });
+    }
+    for (auto& thread: threads) thread.join();
+    EXPECT_EQ(results, std::vector<int>(results.size(), 1));
+    rsa_key_free(key);
+}
@@ -1,4 +1,5 @@
 #include <random>
+#include <thread>
 #include "gtest/gtest.h"
 
 #include "integer/integer.hpp"
@@ -400,4 +401,536 @@ TEST(IntegerTest, ModTest2) {
         BigInt result = big1 % big2;
 
         EXPECT_EQ(convert_hex_to_dec(result.to_string()), sum.str());
-}
\ No newline at end of file
+}
+TEST(IntegerTest, BytesRoundTripTest) {
+    for (int i = 0; i < 10; ++i) {
+        std::string rd = generate_random_large_number(1 + i * 13);
+        BigInt value(rd);
+
+        std::vector<uint8_t> bytes(64);
+        value.to_bytes(bytes.data(), bytes.size());
+
+        BigInt loaded;
+        loaded.from_bytes(bytes.data(), bytes.size());
+        EXPECT_EQ(loaded.to_string(), rd);
+    }
+
+    uint8_t bytes[] = {0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09};
+    BigInt value;
+    value.from_bytes(bytes, sizeof(bytes));
+    EXPECT_EQ(value.to_string(), "0x10203040506070809");
+
+    uint8_t small[4];
+    EXPECT_THROW(value.to_bytes(small, sizeof(small)), std::runtime_error);
+}
+
+TEST(IntegerTest, FullChunkCarryTest) {
+    // limbs of all ones make the carry / borrow of a chunk depend on the incoming one
+    std::string ones = "0x" + std::string(64, 'f');
+    std::string rd = generate_random_large_number(64);
+    cpp_int num1(convert_hex_to_dec(ones));
+    cpp_int num2(convert_hex_to_dec(rd));
+
+    BigInt big1(ones);
+    BigInt big2(rd);
+
+    EXPECT_EQ(convert_hex_to_dec((big1 + big1).to_string()), cpp_int(num1 + num1).str());
+    EXPECT_EQ(convert_hex_to_dec((big1 + big2).to_string()), cpp_int(num1 + num2).str());
+    EXPECT_EQ(convert_hex_to_dec((big1 - big2).to_string()), cpp_int(num1 - num2).str());
+    EXPECT_EQ(convert_hex_to_dec((big1 % big2).to_string()), cpp_int(num1 % num2).str());
+
+    BigInt power("0x2" + std::string(32, '0'));
+    BigInt mod("0x" + std::string(31, 'f') + "e");
+    EXPECT_EQ((power % mod).to_string(), "0x4");
+}
+
+TEST(IntegerTest, NTTMultiplicationTest) {
+    size_t default_threshold = BigInt::ntt_threshold;
+
+    // unbalanced operands, odd lengths and all ones limbs (largest convolution coefficients)
+    std::vector<std::pair<std::string, std::string>> operands = {
+            {generate_random_large_number(3000), generate_random_large_number(3000)},
+            {generate_random_large_number(5003), generate_random_large_number(1777)},
+            {"0x" + std::string(4096, 'f'), "0x" + std::string(4096, 'f')},
+            {"0x" + std::string(4000, 'f'), generate_random_large_number(17)},
+    };
+
+    for (const auto& [rd1, rd2]: operands) {
+        BigInt big1(rd1);
+        BigInt big2(rd2);
+
+        BigInt::ntt_threshold = std::numeric_limits<size_t>::max();
+        BigInt karatsuba = big1 * big2;
+        BigInt::ntt_threshold = 1;
+        BigInt ntt = big1 * big2;
+
+        EXPECT_EQ(ntt, karatsuba);
+
+        cpp_int num1(convert_hex_to_dec(rd1));
+        cpp_int num2(convert_hex_to_dec(rd2));
+        EXPECT_EQ(convert_hex_to_dec(ntt.to_string()), cpp_int(num1 * num2).str());
+    }
+
+    BigInt::ntt_threshold = default_threshold;
+}
+
+TEST(IntegerTest, KnuthDivisionTopChunkTest) {
+    // normalized divisor (no extra chunk from the scaling) and a dividend whose top chunk is above the divisor's
+    std::string rd1 = "0x" + std::string(16, 'f') + std::string(32, '0');
+    std::string rd2 = "0x8" + std::string(15, '0') + std::string(16, 'f');
+    cpp_int num1(convert_hex_to_dec(rd1));
+    cpp_int num2(convert_hex_to_dec(rd2));
+
+    BigInt big1(rd1);
+    BigInt big2(rd2);
+
+    EXPECT_EQ(convert_hex_to_dec((big1 / big2).to_string()), cpp_int(num1 / num2).str());
+    EXPECT_EQ(convert_hex_to_dec((big1 % big2).to_string()), cpp_int(num1 % num2).str());
+}
+
+TEST(IntegerTest, BurnikelZieglerDivisionTest) {
+    size_t default_threshold = BigInt::burnikel_ziegler_threshold;
+    BigInt::burnikel_ziegler_threshold = 4;
+
+    // divisor chunk counts that are not of the form j * 2^k, an all ones divisor and exact divisions
+    std::vector<std::pair<std::string, std::string>> operands = {
+            {generate_random_large_number(3000), generate_random_large_number(1000)},
+            {generate_random_large_number(4321), generate_random_large_number(1234)},
+            {generate_random_large_number(2000), "0x" + std::string(600, 'f')},
+            {"0x" + std::string(2400, 'f'), "0x" + std::string(800, 'f')},
+            {generate_random_large_number(700), generate_random_large_number(650)},
+    };
+
+    for (const auto& [rd1, rd2]: operands) {
+        cpp_int num1(convert_hex_to_dec(rd1));
+        cpp_int num2(convert_hex_to_dec(rd2));
+
+        BigInt big1(rd1);
+        BigInt big2(rd2);
+
+        EXPECT_EQ(convert_hex_to_dec((big1 / big2).to_string()), cpp_int(num1 / num2).str());
+        EXPECT_EQ(convert_hex_to_dec((big1 % big2).to_string()), cpp_int(num1 % num2).str());
+
+        BigInt product = big1 * big2;
+        EXPECT_EQ(product / big2, big1);
+        EXPECT_TRUE((product % big2).is_zero());
+    }
+
+    BigInt::burnikel_ziegler_threshold = default_threshold;
+}
+
+TEST(IntegerTest, SmallBufferStorageTest) {
+    SmallVector<uint64_t, 4> inline_buffer;
+    inline_buffer.resize(3);
+    inline_buffer[2] = 7;
+    EXPECT_TRUE(inline_buffer.is_inline());
+
+    SmallVector<uint64_t, 4> heap_buffer = inline_buffer;
+    heap_buffer.resize(10);
+    EXPECT_FALSE(heap_buffer.is_inline());
+    EXPECT_EQ(heap_buffer[2], 7);
+    EXPECT_EQ(heap_buffer[9], 0);
+
+    // moving steals the heap buffer, inline elements are copied
+    SmallVector<uint64_t, 4> moved_heap = std::move(heap_buffer);
+    EXPECT_FALSE(moved_heap.is_inline());
+    EXPECT_EQ(moved_heap.size(), 10);
+    EXPECT_EQ(heap_buffer.size(), 0);
+
+    moved_heap = std::move(inline_buffer);
+    EXPECT_TRUE(moved_heap.is_inline());
+    EXPECT_EQ(moved_heap.size(), 3);
+    EXPECT_EQ(moved_heap[2], 7);
+
+    // integers on both sides of the inline capacity
+    for (size_t digits: {8, 200, 2000}) {
+        std::string rd1 = generate_random_large_number(digits);
+        std::string rd2 = generate_random_large_number(digits);
+        cpp_int num1(convert_hex_to_dec(rd1));
+        cpp_int num2(convert_hex_to_dec(rd2));
+
+        BigInt big1(rd1);
+        BigInt big2(rd2);
+        BigInt copy = big1;
+        BigInt moved = std::move(copy);
+        moved = moved * big2;
+        big2 = moved;
+
+        EXPECT_EQ(convert_hex_to_dec(big2.to_string()), cpp_int(num1 * num2).str());
+    }
+}
+
+TEST(IntegerTest, FixedMontgomeryExpTest) {
+    auto check = [](const std::string& mod_hex, const std::string& base_hex, const std::string& exp_hex, auto kernel) {
+        BigInt mod(mod_hex);
+        BigInt base(base_hex);
+        BigInt exp(exp_hex);
+        EXPECT_EQ(kernel(base, exp, mod), BigInt::fast_odd_exp_mod(base, exp, mod));
+    };
+
+    auto random_odd = [](size_t digits) {
+        std::string value = generate_random_large_number(digits);
+        value.back() = "13579bdf"[value.back() % 8];
+        return value;
+    };
+
+    for (int i = 0; i < 3; ++i) {
+        check(random_odd(256), generate_random_large_number(250), generate_random_large_number(256), BigInt::fixed_odd_exp_mod<16>);
+        check(random_odd(512), generate_random_large_number(512), generate_random_large_number(500), BigInt::fixed_odd_exp_mod<32>);
+        check(random_odd(768), generate_random_large_number(700), "0x10001", BigInt::fixed_odd_exp_mod<48>);
+        check(random_odd(1024), generate_random_large_number(1024), generate_random_large_number(64), BigInt::fixed_odd_exp_mod<64>);
+    }
+
+    // all ones modulus, base above the modulus, zero exponent and a size the kernel does not cover
+    check("0x" + std::string(512, 'f'), "0x" + std::string(512, 'f') + "123", generate_random_large_number(512), BigInt::fixed_odd_exp_mod<32>);
+    check(random_odd(512), generate_random_large_number(300), "0x0", BigInt::fixed_odd_exp_mod<32>);
+    check(random_odd(300), generate_random_large_number(300), generate_random_large_number(300), BigInt::fixed_odd_exp_mod<32>);
+}
+
+TEST(IntegerTest, ArenaScopeTest) {
+    auto& arena = LimbArena::local();
+    std::string rd1 = generate_random_large_number(2000);
+    std::string rd2 = generate_random_large_number(2000);
+    cpp_int expected = cpp_int(convert_hex_to_dec(rd1)) * cpp_int(convert_hex_to_dec(rd2));
+
+    BigInt big1(rd1);
+    BigInt big2(rd2);
+
+    ArenaScope::run([&] {
+        BigInt product = big1 * big2;
+        EXPECT_GT(arena.used, 0);
+        EXPECT_EQ(convert_hex_to_dec(product.to_string()), expected.str());
+    });
+    EXPECT_EQ(arena.used, 0);
+
+    // the result leaves the scope on the heap, later scopes reuse (and overwrite) the arena
+    BigInt product = ArenaScope::run([&] { return big1 * big2; });
+    EXPECT_EQ(arena.used, 0);
+    ArenaScope::run([&] { BigInt other = big2 * big2 * big2; });
+    EXPECT_EQ(convert_hex_to_dec(product.to_string()), expected.str());
+
+    // also the result of a nested scope, stored beyond the outer one
+    BigInt nested;
+    ArenaScope::run([&] {
+        BigInt temporary = big2 * big2;
+        nested = ArenaScope::run([&] { return big1 * big2; });
+    });
+    ArenaScope::run([&] { BigInt other = big2 * big2 * big2; });
+    EXPECT_EQ(convert_hex_to_dec(nested.to_string()), expected.str());
+
+    // past max_bytes the operation continues on the heap
+    size_t default_max_bytes = LimbArena::max_bytes;
+    LimbArena::max_bytes = 1024;
+    ArenaScope::run([&] {
+        BigInt limited = big1 * big2;
+        EXPECT_LE(arena.used, 1024);
+        EXPECT_EQ(convert_hex_to_dec(limited.to_string()), expected.str());
+    });
+    LimbArena::max_bytes = default_max_bytes;
+
+    // a HeapScope inside the scope keeps the arena out, the value survives the reset
+    BigInt kept;
+    ArenaScope::run([&] {
+        HeapScope heap;
+        kept = big1 * big2;
+        EXPECT_EQ(arena.used, 0);
+    });
+    ArenaScope::run([&] { BigInt other = big2 * big2 * big2; });
+    EXPECT_EQ(convert_hex_to_dec(kept.to_string()), expected.str());
+
+    // buffers record their origin, an arena buffer may be released on another thread
+    BigInt* shared = nullptr;
+    ArenaScope::run([&] {
+        shared = new BigInt(big1 * big2);
+        std::thread([&] { delete shared; }).join();
+    });
+}
+
+TEST(IntegerTest, MontgomeryIntTest) {
+    for (size_t digits: {16, 256, 512}) {
+        std::string mod_hex = generate_random_large_number(digits);
+        mod_hex.back() = "13579bdf"[mod_hex.back() % 8];
+        std::string rd1 = generate_random_large_number(digits);
+        std::string rd2 = generate_random_large_number(digits / 2);
+        cpp_int mod(convert_hex_to_dec(mod_hex));
+        cpp_int num1(convert_hex_to_dec(rd1));
+        cpp_int num2(convert_hex_to_dec(rd2));
+
+        BigInt::MontgomeryContext context{BigInt(mod_hex)};
+        using MontgomeryInt = BigInt::MontgomeryInt;
+        MontgomeryInt a(context, BigInt(rd1));
+        MontgomeryInt b(context, BigInt(rd2));
+
+        // (a * b + a - b)^2 * b, staying in Montgomery form until the end
+        MontgomeryInt x = a * b + a - b;
+        x = x.square();
+        x *= b;
+        cpp_int y = ((num1 % mod) * num2 + num1 + mod - num2 % mod) % mod;
+        y = (y * y * num2) % mod;
+        EXPECT_EQ(convert_hex_to_dec(x.to_integer().to_string()), y.str());
+
+        EXPECT_EQ(convert_hex_to_dec(a.pow(BigInt(rd2)).to_integer().to_string()), mod_exp(num1, num2, mod).str());
+        EXPECT_TRUE(b - b == MontgomeryInt(context, BigInt(0)));
+        EXPECT_TRUE(-MontgomeryInt::one(context) + MontgomeryInt::one(context) == MontgomeryInt(context, BigInt(0)));
+        EXPECT_TRUE(MontgomeryInt(context, BigInt(mod_hex) + BigInt(rd1)) == a);
+    }
+}
+
+TEST(IntegerTest, ArbitraryShiftTest) {
+    std::string rd = generate_random_large_number(300);
+    cpp_int num(convert_hex_to_dec(rd));
+    BigInt big(rd);
+
+    for (size_t shift: {0, 1, 31, 63, 64, 65, 128, 700, 1199, 1200, 1500}) {
+        EXPECT_EQ(convert_hex_to_dec((big >> shift).to_string()), cpp_int(num >> shift).str()) << shift;
+        EXPECT_EQ(convert_hex_to_dec((big << shift).to_string()), cpp_int(num << shift).str()) << shift;
+
+        BigInt shifted = big;
+        shifted <<= shift;
+        shifted >>= shift;
+        EXPECT_EQ(shifted, big) << shift;
+    }
+
+    // windows across chunk boundaries and past the top
+    for (size_t pos: {0, 3, 60, 62, 63, 64, 127, 1190, 1196, 1300}) {
+        for (size_t width: {1, 4, 5, 64}) {
+            cpp_int expected = (num >> pos) & ((cpp_int(1) << width) - 1);
+            EXPECT_EQ(cpp_int(big.get_bits(pos, width)), expected) << pos << " " << width;
+        }
+    }
+
+    // every exponent window width of MontgomeryContext::pow
+    std::string mod_hex = generate_random_large_number(256);
+    mod_hex.back() = "13579bdf"[mod_hex.back() % 8];
+    cpp_int mod(convert_hex_to_dec(mod_hex));
+    for (size_t digits: {1, 5, 16, 64, 256}) {
+        std::string exp = generate_random_large_number(digits);
+        EXPECT_EQ(convert_hex_to_dec(BigInt::fast_odd_exp_mod(big, BigInt(exp), BigInt(mod_hex)).to_string()),
+                  mod_exp(num, cpp_int(convert_hex_to_dec(exp)), mod).str()) << digits;
+    }
+}
+
+TEST(IntegerTest, ExpModContextTest) {
+    auto random_odd = [](size_t digits) {
+        std::string value = generate_random_large_number(digits);
+        value.back() = "13579bdf"[value.back() % 8];
+        return BigInt(value);
+    };
+
+    // fixed kernel sizes, a generic size and a one chunk modulus
+    for (size_t digits: {256, 512, 300, 16}) {
+        BigInt mod = random_odd(digits);
+        BigInt::ExpModContext context(mod);
+        BigInt base(generate_random_large_number(digits + 3));
+
+        for (const char* exp: {"0x0", "0x1", "0x2", "0x3", "0x10001", "0xffffffffffffffff", "0x10000000000000000"}) {
+            EXPECT_EQ(context.pow(base, BigInt(exp)), BigInt::fast_odd_exp_mod(base, BigInt(exp), mod)) << digits << " " << exp;
+        }
+        BigInt exp(generate_random_large_number(digits));
+        EXPECT_EQ(context.pow(base, exp), BigInt::fast_odd_exp_mod(base, exp, mod)) << digits;
+    }
+}
+
+TEST(IntegerTest, ParallelMultiplicationTest) {
+    // this machine may have a single core, the pool still gets workers to exercise the task path
+    TaskPool::global_workers = std::max<size_t>(TaskPool::global_workers, 3);
+    size_t default_threshold = BigInt::parallel_threshold;
+    BigInt::parallel_threshold = 129;
+
+    // balanced, unbalanced and above the NTT threshold
+    std::vector<std::pair<std::string, std::string>> operands = {
+            {generate_random_large_number(4096), generate_random_large_number(4096)},
+            {generate_random_large_number(8191), generate_random_large_number(3001)},
+            {generate_random_large_number(30000), generate_random_large_number(27000)},
+    };
+
+    for (const auto& [rd1, rd2]: operands) {
+        BigInt big1(rd1);
+        BigInt big2(rd2);
+        EXPECT_EQ(big1.parallel_multiply(big2), big1 * big2);
+        ArenaScope::run([&] { EXPECT_EQ(big2.parallel_multiply(big1), big1 * big2); });
+    }
+
+    BigInt::parallel_threshold = default_threshold;
+
+    // nested calls and exceptions from tasks reach the caller
+    std::atomic<int> count = 0;
+    auto nested = [&] { TaskPool::global().invoke([&] { count++; }, [&] { count++; }); };
+    TaskPool::global().invoke(nested, nested, nested);
+    EXPECT_EQ(count, 6);
+    EXPECT_THROW(TaskPool::global().invoke([] {}, [] { throw std::runtime_error("task"); }), std::runtime_error);
+}
+
+TEST(IntegerTest, ArenaInPoolTasksTest) {
+    TaskPool pool(3);
+    BigInt big(generate_random_large_number(2000));
+    BigInt square = big * big;
+
+    // scopes opened by tasks bump-allocate on whichever thread runs them, and keep the waiting scope intact
+    std::atomic<size_t> bumped = 0;
+    std::atomic<size_t> on_workers = 0;
+    auto caller = std::this_thread::get_id();
+    // tasks only go to idle workers, the rounds repeat until the workers have started and taken some
+    for (int round = 0; round < 100 and on_workers == 0; round++) {
+        bumped = 0;
+        ArenaScope::run([&] {
+            BigInt outer = big * big;
+            pool.for_each(32, [&](size_t i) {
+                // the caller holds on to its first task until a worker has finished one of the others
+                auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(50);
+                while (i == 0 and on_workers == 0 and std::chrono::steady_clock::now() < deadline) {
+                    std::this_thread::yield();
+                }
+                BigInt product = ArenaScope::run([&] {
+                    auto& arena = LimbArena::local();
+                    size_t before = arena.used;
+                    BigInt result = big * big;
+                    if (arena.active() and arena.used > before) bumped++;
+                    return result;
+                });
+                EXPECT_EQ(product, square);
+                if (std::this_thread::get_id() != caller) on_workers++;
+            });
+            EXPECT_EQ(outer, square);
+        });
+        EXPECT_EQ(bumped, 32);
+    }
+    EXPECT_GT(on_workers, 0);
+    EXPECT_EQ(LimbArena::local().used, 0);
+}
+
+TEST(IntegerTest, DivmodTest) {
+    // digits from few values hit the quotient corrections and the add back step much more often than random ones
+    std::mt19937 gen(12345);
+    auto pattern_number = [&](size_t digits) {
+        std::string value = "0x";
+        for (size_t i = 0; i < digits; i++) value += "0f78"[gen() % 4];
+        return value;
+    };
+
+    std::vector<std::pair<std::string, std::string>> operands = {
+            {generate_random_large_number(512), generate_random_large_number(256)},
+            {generate_random_large_number(512), generate_random_large_number(16)},
+            {generate_random_large_number(512), generate_random_large_number(5)},
+            {generate_random_large_number(256), generate_random_large_number(256)},
+            {generate_random_large_number(100), generate_random_large_number(300)},
+            {"0x" + std::string(64, 'f'), "0x" + std::string(32, 'f')},
+            // q_hat = 4 passes the two chunk check, the quotient is 3 (add back step)
+            {"0x8" + std::string(47, '0') + "3", "0x2" + std::string(47, '0') + "1"},
+    };
+    for (int i = 0; i < 2000; i++) {
+        operands.emplace_back(pattern_number(16 + gen() % 80), pattern_number(17 + gen() % 32));
+    }
+
+    for (const auto& [rd1, rd2]: operands) {
+        BigInt big1(rd1);
+        BigInt big2(rd2);
+        if (big2.is_zero()) continue;
+
+        auto [quotient, reminder] = big1.divmod(big2);
+        EXPECT_LT(reminder, big2) << rd1 << " " << rd2;
+        EXPECT_EQ(quotient * big2 + reminder, big1) << rd1 << " " << rd2;
+    }
+
+    for (size_t i = 0; i < 7; i++) {
+        const auto& [rd1, rd2] = operands[i];
+        auto [quotient, reminder] = BigInt(rd1).divmod(BigInt(rd2));
+        cpp_int num1(convert_hex_to_dec(rd1));
+        cpp_int num2(convert_hex_to_dec(rd2));
+        EXPECT_EQ(convert_hex_to_dec(quotient.to_string()), cpp_int(num1 / num2).str());
+        EXPECT_EQ(convert_hex_to_dec(reminder.to_string()), cpp_int(num1 % num2).str());
+    }
+
+    EXPECT_THROW(BigInt(7).divmod(BigInt(0)), std::runtime_error);
+}
+
+TEST(IntegerTest, ExpressionTemplateTest) {
+    std::mt19937 gen(2024);
+    auto pattern_number = [&](size_t digits) {
+        std::string value = "0x1";
+        for (size_t i = 1; i < digits; i++) value += "0f8"[gen() % 3];
+        return BigInt(value);
+    };
+
+    // long multiplication rows and the Karatsuba fallback (more than karatsuba_threshold chunks)
+    for (size_t digits: {1, 7, 16, 33, 64, 200, 2200, 2400}) {
+        for (int round = 0; round < 20; round++) {
+            BigInt a = pattern_number(digits), b = pattern_number(1 + gen() % (digits + 4)), c = pattern_number(1 + gen() % (2 * digits + 8));
+            BigInt product = a * b;
+
+            BigInt sum = c + BigInt::lazy(a) * b;
+            EXPECT_EQ(sum, c + product);
+            BigInt shifted = (c + BigInt::lazy(a) * b) >> 70;
+            EXPECT_EQ(shifted, (c + product) >> 70);
+            BigInt low = (BigInt::lazy(a) * b).mod_2_pow(128);
+            EXPECT_EQ(low, product % (BigInt(1) << 128));
+
+            BigInt larger = c + product;
+            BigInt difference = larger - BigInt::lazy(a) * b;
+            EXPECT_EQ(difference, c);
+
+            BigInt accumulated = c;
+            accumulated += BigInt::lazy(a) * b;
+            EXPECT_EQ(accumulated, c + product);
+            accumulated -= BigInt::lazy(b) * a;
+            EXPECT_EQ(accumulated, c);
+        }
+    }
+
+    // the destination may be the addend or one of the factors
+    BigInt a = pattern_number(40), b = pattern_number(30), c = pattern_number(50);
+    BigInt expected = c + a * b;
+    BigInt x = c;
+    x = x + BigInt::lazy(a) * b;
+    EXPECT_EQ(x, expected);
+    x = a;
+    x = c + BigInt::lazy(x) * b;
+    EXPECT_EQ(x, expected);
+    x = a;
+    x += BigInt::lazy(x) * x;
+    EXPECT_EQ(x, a + a * a);
+
+    // signed multiply-add over all sign combinations against the eager operators
+    for (int round = 0; round < 200; round++) {
+        SignedBigInt sa(pattern_number(1 + gen() % 40)), sb(pattern_number(1 + gen() % 40)), sc(pattern_number(1 + gen() % 80));
+        sa.sign = gen() % 2;
+        sb.sign = gen() % 2;
+        sc.sign = gen() % 2;
+        SignedBigInt eager_sum = sc + sa * sb, fused_sum = sc + SignedBigInt::lazy(sa) * sb;
+        SignedBigInt eager_difference = sc - sa * sb, fused_difference = sc - SignedBigInt::lazy(sa) * sb;
+        EXPECT_EQ(fused_sum.abs, eager_sum.abs);
+        EXPECT_EQ(fused_difference.abs, eager_difference.abs);
+        if (not eager_sum.abs.is_zero()) {
+            EXPECT_EQ(fused_sum.sign, eager_sum.sign);
+        }
+        if (not eager_difference.abs.is_zero()) {
+            EXPECT_EQ(fused_difference.sign, eager_difference.sign);
+        }
+    }
+}
+
+TEST(IntegerTest, RnsExpModTest) {
+    auto random_odd = [](size_t digits) {
+        std::string value = generate_random_large_number(digits);
+        value.back() = "13579bdf"[value.back() % 8];
+        return BigInt(value);
+    };
+
+    // one chunk, sizes that are not a multiple of 32 bits, RSA sizes
+    for (size_t digits: {4, 16, 75, 512, 1024}) {
+        BigInt mod = random_odd(digits);
+        BigInt base(generate_random_large_number(digits + 3));
+        for (const char* exp: {"0x0", "0x1", "0x2", "0x10001"}) {
+            EXPECT_EQ(BigInt::rns_odd_exp_mod(base, BigInt(exp), mod), BigInt::fast_odd_exp_mod(base, BigInt(exp), mod)) << digits << " " << exp;
+        }
+        BigInt exp(generate_random_large_number(digits));
+        EXPECT_EQ(BigInt::rns_odd_exp_mod(base, exp, mod), BigInt::fast_odd_exp_mod(base, exp, mod)) << digits;
+    }
+
+    // a modulus divisible by the largest channel primes, which the bases have to skip
+    BigInt mod = BigInt("0xfffffffb") * BigInt("0xffffffef") * random_odd(200);
+    BigInt base(generate_random_large_number(220));
+    BigInt exp(generate_random_large_number(200));
+    EXPECT_EQ(BigInt::rns_odd_exp_mod(base, exp, mod), BigInt::fast_odd_exp_mod(base, exp, mod));
+    EXPECT_EQ(BigInt::rns_odd_exp_mod(BigInt("0xfffffffb"), exp, mod), BigInt::fast_odd_exp_mod(BigInt("0xfffffffb"), exp, mod));
+}
@@ -0,0 +1,68 @@
+#include "gtest/gtest.h"
+
+#include "key_pair_pool.hpp"
+
+TEST(KeyPairPoolTest, TakeFromFilledPool) {
+    KeyPairPool<BigInt> pool(2, false);
+    pool.reserve(256, 2);
+
+    while (pool.refill_one()) {}
+    EXPECT_EQ(pool.available(256), 2);
+    EXPECT_FALSE(pool.refill_one());
+
+    auto [public_key, private_key] = pool.take(256);
+    EXPECT_EQ(public_key.n, private_key.p * private_key.q);
+    EXPECT_EQ(pool.available(256), 1);
+
+    auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.hits, 1);
+    EXPECT_EQ(metrics.misses, 0);
+    EXPECT_EQ(metrics.generated, 2);
+    EXPECT_GE(metrics.max_refill_lag, metrics.last_refill_lag);
+}
+
+TEST(KeyPairPoolTest, MissFallsBackToSynchronousGeneration) {
+    KeyPairPool<BigInt> pool(1, false);
+
+    EXPECT_FALSE(pool.try_take(256).has_value());
+    auto [public_key, private_key] = pool.take(256);
+    EXPECT_EQ(public_key.n, private_key.p * private_key.q);
+
+    auto metrics = pool.metrics();
+    EXPECT_EQ(metrics.hits, 0);
+    EXPECT_EQ(metrics.misses, 2);
+    EXPECT_DOUBLE_EQ(metrics.hit_rate(), 0.0);
+}
+
+TEST(KeyPairPoolTest, BackgroundRefill) {
+    KeyPairPool<BigInt> pool;
+    pool.reserve(256, 3);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+    while (pool.available(256) < 3 and std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    ASSERT_EQ(pool.available(256), 3);
+
+    auto [public_key, private_key] = pool.take(256);
+    EXPECT_EQ(public_key.n, private_key.p * private_key.q);
+    EXPECT_EQ(pool.metrics().hits, 1);
+}
+
+TEST(KeyPairPoolTest, ShrinkCapacity) {
+    KeyPairPool<BigInt> pool(1, false);
+    pool.reserve(256, 3);
+    ASSERT_TRUE(pool.refill_one());
+    ASSERT_TRUE(pool.refill_one());
+
+    // one key pair more than the new capacity is ready, the last pending refill is dropped
+    pool.reserve(256, 1);
+    EXPECT_EQ(pool.available(256), 1);
+    EXPECT_FALSE(pool.refill_one());
+
+    // a taken key pair is refilled up to the new capacity only
+    pool.take(256);
+    EXPECT_TRUE(pool.refill_one());
+    EXPECT_FALSE(pool.refill_one());
+    EXPECT_EQ(pool.available(256), 1);
+}
@@ -1,6 +1,7 @@
 #include "gtest/gtest.h"
 
 #include "integer/prime_generator.hpp"
+#include "boost/multiprecision/cpp_int.hpp"
 //#include "boost/multiprecision/cpp_int.hpp"
 //
 //#include "integer/integer.hpp"
@@ -23,4 +24,105 @@ TEST(PrimeGeneratorTest, PrimeTableTest) {
 //    auto result = PrimeGenerator<cpp_int>::generate_primes(1000);
 //    std::cout << result.size() << std::endl;
 //     FAIL();
-}
\ No newline at end of file
+}
+TEST(PrimeGeneratorTest, BailliePSWSmallNumbersTest) {
+    using Generator = PrimeGenerator<BigInt>;
+    auto primes = Generator::generate_primes(3000);
+    std::vector<bool> is_prime(20000, false);
+    for (auto p: primes) {
+        if (p < is_prime.size()) is_prime[p] = true;
+    }
+
+    for (int i = 5; i < 20000; i += 2) {
+        EXPECT_EQ(Generator::pass_baillie_psw(BigInt(i), 0), is_prime[i]) << i;
+    }
+}
+
+TEST(PrimeGeneratorTest, BailliePSWPseudoprimeTest) {
+    using Generator = PrimeGenerator<BigInt>;
+
+    // strong pseudoprimes to base 2 fail the Lucas part
+    for (int value: {2047, 3277, 4033, 4681, 8321}) {
+        EXPECT_TRUE(Generator::pass_miller_rabin_base_2(BigInt(value))) << value;
+        EXPECT_FALSE(Generator::pass_strong_lucas(BigInt(value))) << value;
+    }
+
+    // strong Lucas pseudoprimes fail the base 2 part
+    for (int value: {5459, 5777, 10877, 16109, 18971}) {
+        EXPECT_TRUE(Generator::pass_strong_lucas(BigInt(value))) << value;
+        EXPECT_FALSE(Generator::pass_miller_rabin_base_2(BigInt(value))) << value;
+    }
+
+    // 2^127 - 1 and 2^521 - 1 are prime, their product is not
+    BigInt m127("0x7" + std::string(31, 'f'));
+    BigInt m521("0x1" + std::string(130, 'f'));
+    EXPECT_TRUE(Generator::pass_baillie_psw(m127, 0));
+    EXPECT_TRUE(Generator::pass_baillie_psw(m521, 2));
+    EXPECT_FALSE(Generator::pass_baillie_psw(m127 * m521, 0));
+}
+
+TEST(PrimeGeneratorTest, FastBase2ExpTest) {
+    BigInt mod("0xf353b8d83730c1556039a1570fc40c94b73c32a8a8d95cbdeadf2120cf7b52a8e3c8e54a9a5899fee7c07478ad8a371bb14e5a1e32912d7f56d82ac1bbdd4747");
+    BigInt exp("0x9a5899fee7c07478ad8a371bb14e5a1e32912d7f56d82ac1bbdd4747b699894143a6d225d94feac3ea");
+    EXPECT_EQ(BigInt::fast_odd_exp_mod_base_2(exp, mod), BigInt::fast_odd_exp_mod(BigInt(2), exp, mod));
+}
+
+TEST(PrimeGeneratorTest, SearchErrorTest) {
+    // an exception of a search thread reaches the caller instead of restarting the search
+    auto validator = [](const BigInt&, const std::vector<BigInt>&) -> bool {
+        throw std::invalid_argument("rejected");
+    };
+    EXPECT_THROW(PrimeGenerator<BigInt>::get_primes({64, 64}, validator), std::invalid_argument);
+}
+
+TEST(PrimeGeneratorTest, ChaCha20RandomTest) {
+    // keystream of the all zero key and nonce: 76 b8 e0 ad a0 f1 3d 90 40 5d 6a e5 53 86 bd 28 ...
+    ChaCha20 zero({}, 0);
+    EXPECT_EQ(zero(), 0x903df1a0ade0b876ULL);
+    EXPECT_EQ(zero(), 0x28bd8653e56a5d40ULL);
+
+    // seeded generators repeat, other threads draw other streams
+    auto draw = [] {
+        std::vector<uint64_t> values;
+        for (int i = 0; i < 20; i++) values.push_back(Random::local()());
+        return values;
+    };
+    Random::seed(42);
+    auto first = draw();
+    BigInt first_candidate = PrimeGenerator<BigInt>::random_odd_integer(256);
+    Random::seed(42);
+    EXPECT_EQ(draw(), first);
+    EXPECT_EQ(PrimeGenerator<BigInt>::random_odd_integer(256), first_candidate);
+
+    std::vector<uint64_t> other;
+    std::thread([&] { other = draw(); }).join();
+    EXPECT_NE(other, first);
+    Random::seed_from_device();
+    EXPECT_NE(draw(), first);
+
+    // exactly the requested bit count, odd candidates
+    for (size_t bits: {1, 4, 63, 64, 65, 1024}) {
+        EXPECT_EQ(BigInt::random(bits, Random::local()).msb(), bits);
+    }
+    BigInt candidate = PrimeGenerator<BigInt>::random_odd_integer(256);
+    EXPECT_EQ(candidate.msb(), 1024);
+    EXPECT_EQ(candidate.bit_test(0), 1);
+}
+
+TEST(PrimeGeneratorTest, GenericIntegerTest) {
+    // an integer type without Montgomery arithmetic goes through mod_exp
+    using boost::multiprecision::cpp_int;
+    using Generator = PrimeGenerator<cpp_int>;
+    static_assert(not Generator::has_montgomery);
+
+    EXPECT_TRUE(Generator::pass_miller_rabin(cpp_int(65537), 20));
+    EXPECT_TRUE(Generator::pass_miller_rabin((cpp_int(1) << 127) - 1, 20));
+    EXPECT_FALSE(Generator::pass_miller_rabin(cpp_int(65537) * 65539, 20));
+    // Carmichael number
+    EXPECT_FALSE(Generator::pass_miller_rabin(cpp_int(41041), 20));
+
+    // above the range of the random bases
+    for (int i = 40001; i < 42000; i += 2) {
+        EXPECT_EQ(Generator::pass_miller_rabin(cpp_int(i), 20), PrimeGenerator<BigInt>::pass_miller_rabin(BigInt(i), 20)) << i;
+    }
+}
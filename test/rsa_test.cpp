@@ -1,7 +1,10 @@
+#include <sstream>
+
 #include "gtest/gtest.h"
 
 #include "spdlog/spdlog.h"
 
+#include "key_file.hpp"
 #include "rsa.hpp"
 
 TEST(RSATest, EncryptAndDecrypt) {
@@ -27,4 +30,260 @@ TEST(RSATest, EncryptAndDecrypt) {
     spdlog::info(tmp2.to_string());
 
     EXPECT_EQ(decrypted.to_string(), a.to_string());
-}
\ No newline at end of file
+}
+TEST(RSATest, MultiPrimeEncryptAndDecrypt) {
+    BigInt a("0x20536f6d652054657874204865726520");
+
+    for (size_t prime_count: {2, 3, 4}) {
+        RSA<BigInt> rsa_manager;
+        auto [public_key, private_key] = rsa_manager.generate_key_pair(768, prime_count);
+
+        ASSERT_EQ(private_key.primes.size(), prime_count);
+        BigInt n{1};
+        for (auto& prime: private_key.primes) n = n * prime;
+        EXPECT_EQ(n, public_key.n);
+
+        BigInt cipher = rsa_manager.encrypt(a);
+        EXPECT_EQ(rsa_manager.decrypt(cipher).to_string(), a.to_string());
+
+        // CRT result must match the plain exponentiation by d
+        BigInt signature = rsa_manager.sign(a);
+        EXPECT_EQ(signature, BigInt::fast_odd_exp_mod(a, private_key.d, private_key.n));
+        EXPECT_TRUE(rsa_manager.verify(a, signature));
+    }
+}
+
+TEST(RSATest, KeyGenModesTest) {
+    BigInt a("0x20536f6d652054657874204865726520");
+
+    for (auto mode: {KeyGenMode::sequential, KeyGenMode::concurrent}) {
+        RSA<BigInt> rsa_manager;
+        rsa_manager.keygen_mode = mode;
+        auto [public_key, private_key] = rsa_manager.generate_key_pair(512, 3);
+
+        for (size_t i = 0; i < private_key.primes.size(); i++) {
+            for (size_t j = 0; j < i; j++) {
+                EXPECT_TRUE(RSA<BigInt>::accept_prime(private_key.primes[i], {private_key.primes[j]}, public_key.e));
+            }
+        }
+        EXPECT_EQ(rsa_manager.decrypt(rsa_manager.encrypt(a)), a);
+    }
+}
+
+TEST(RSATest, ModulusBitLengthTest) {
+    // without forced leading bits about a third of the two-prime moduli came out one bit short
+    for (auto mode: {KeyGenMode::sequential, KeyGenMode::concurrent}) {
+        for (size_t prime_count: {2, 3, 5}) {
+            RSA<BigInt> rsa_manager;
+            rsa_manager.keygen_mode = mode;
+            for (int i = 0; i < 8; i++) {
+                auto [public_key, private_key] = rsa_manager.generate_key_pair(128, prime_count);
+                EXPECT_EQ(public_key.n.msb(), 256) << prime_count;
+            }
+        }
+    }
+}
+
+TEST(RSATest, AcceptPrimeTest) {
+    BigInt e("0x10001");
+    BigInt p = PrimeGenerator<BigInt>::get_prime(64);
+
+    // p itself and a prime right next to p are too close
+    EXPECT_FALSE(RSA<BigInt>::accept_prime(p, {p}, e));
+    BigInt next = p + 2;
+    while (not PrimeGenerator<BigInt>::is_prime(next)) next = next + 2;
+    EXPECT_FALSE(RSA<BigInt>::accept_prime(next, {p}, e));
+
+    // 65537 divides 65537 * 2 + 1 - 1
+    EXPECT_FALSE(RSA<BigInt>::accept_prime(BigInt(131075), {}, e));
+    EXPECT_TRUE(RSA<BigInt>::accept_prime(p, {}, e) == (not ((p - 1) % 65537 == 0)));
+}
+
+TEST(RSATest, FixedKernelSelectionTest) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(1024);
+
+    auto kernels = rsa_manager.kernels();
+    ASSERT_TRUE(kernels->public_context.has_value());
+    EXPECT_EQ(kernels->public_context->fixed_limbs(), 32);
+    ASSERT_EQ(kernels->prime_contexts.size(), 2);
+    ASSERT_TRUE(kernels->prime_contexts[0].has_value());
+    EXPECT_EQ(kernels->prime_contexts[0]->fixed_limbs(), 16);
+    EXPECT_EQ(rsa_manager.kernels(), kernels);
+
+    BigInt message("0x123456789abcdef");
+    EXPECT_EQ(rsa_manager.decrypt(rsa_manager.encrypt(message)), message);
+    EXPECT_TRUE(rsa_manager.verify(message, rsa_manager.sign(message)));
+}
+
+TEST(RSATest, SignMessageTest) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(512);
+
+    BigInt signature = rsa_manager.sign_message("Some Text Here");
+    EXPECT_TRUE(rsa_manager.verify_message("Some Text Here", signature));
+    EXPECT_FALSE(rsa_manager.verify_message("Some Text Here.", signature));
+    EXPECT_FALSE(rsa_manager.verify_message("Some Text Here", signature + 1));
+    EXPECT_FALSE(rsa_manager.verify_message("Some Text Here", signature + rsa_manager.public_key.n));
+
+    // 0x00 0x01 0xff .. 0xff 0x00 DigestInfo digest over the 128 bytes of the modulus
+    auto digest = Sha256::hash("Some Text Here");
+    uint8_t encoded[128];
+    rsa_manager.encode_digest(digest).to_bytes(encoded, sizeof(encoded));
+    EXPECT_EQ(encoded[0], 0x00);
+    EXPECT_EQ(encoded[1], 0x01);
+    EXPECT_EQ(encoded[128 - 52], 0x00);
+    EXPECT_TRUE(std::all_of(encoded + 2, encoded + 128 - 52, [](uint8_t byte) { return byte == 0xff; }));
+    EXPECT_EQ(encoded[128 - 51], 0x30);
+    EXPECT_TRUE(std::equal(digest.begin(), digest.end(), encoded + 128 - 32));
+
+    std::vector<std::string> storage;
+    for (int i = 0; i < 20; i++) storage.push_back("message " + std::to_string(i) + std::string(i * 7, 'x'));
+    std::vector<std::string_view> messages(storage.begin(), storage.end());
+
+    auto signatures = rsa_manager.sign_messages(messages);
+    ASSERT_EQ(signatures.size(), messages.size());
+    for (size_t i = 0; i < messages.size(); i++) {
+        EXPECT_EQ(signatures[i], rsa_manager.sign_message(messages[i])) << i;
+    }
+
+    std::swap(signatures[3], signatures[4]);
+    auto valid = rsa_manager.verify_messages(messages, signatures);
+    for (size_t i = 0; i < messages.size(); i++) {
+        EXPECT_EQ(valid[i], i != 3 and i != 4) << i;
+    }
+}
+
+TEST(RSATest, PublicContextTest) {
+    RSA<BigInt> rsa_manager;
+    auto [public_key, private_key] = rsa_manager.generate_key_pair(1024);
+    ASSERT_TRUE(rsa_manager.kernels()->public_context.has_value());
+
+    BigInt message("0x123456789abcdef");
+    BigInt cipher = rsa_manager.encrypt(message);
+    EXPECT_EQ(cipher, BigInt::fast_odd_exp_mod(message, public_key.e, public_key.n));
+    EXPECT_EQ(rsa_manager.decrypt(cipher), message);
+
+    // keys assigned without select_kernels get their own contexts instead of the stale ones
+    RSA<BigInt> other;
+    auto [other_public, other_private] = other.generate_key_pair(768);
+    rsa_manager.public_key = other_public;
+    EXPECT_EQ(rsa_manager.encrypt(message), BigInt::fast_odd_exp_mod(message, other_public.e, other_public.n));
+    EXPECT_EQ(rsa_manager.kernels()->public_context->mod, other_public.n);
+    rsa_manager.private_key = other_private;
+    EXPECT_TRUE(rsa_manager.verify(message, other.sign(message)));
+    EXPECT_EQ(rsa_manager.sign(message), other.sign(message));
+    EXPECT_EQ(rsa_manager.kernels()->prime_contexts[0]->mod, other_private.primes[0]);
+}
+
+TEST(RSATest, CancellableKeyGenTest) {
+    using namespace std::chrono_literals;
+    BigInt a("0x20536f6d652054657874204865726520");
+
+    for (auto mode: {KeyGenMode::sequential, KeyGenMode::concurrent}) {
+        RSA<BigInt> rsa_manager;
+        rsa_manager.keygen_mode = mode;
+
+        // already cancelled / expired
+        std::stop_source cancelled;
+        cancelled.request_stop();
+        EXPECT_THROW(rsa_manager.generate_key_pair(1024, KeyGenOptions{.stop_token = cancelled.get_token()}), SearchCancelled);
+        EXPECT_THROW(rsa_manager.generate_key_pair(1024, KeyGenOptions{.deadline = std::chrono::steady_clock::now()}), SearchCancelled);
+
+        // a search far longer than the deadline stops shortly after it
+        auto start = std::chrono::steady_clock::now();
+        EXPECT_THROW(rsa_manager.generate_key_pair(8192, KeyGenOptions{.deadline = start + 20ms}), SearchCancelled);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+
+        std::stop_source stop_source;
+        auto progress = std::make_shared<KeyGenProgress>();
+        auto future = rsa_manager.generate_key_pair_async(8192, {.stop_token = stop_source.get_token(), .progress = progress});
+        std::this_thread::sleep_for(20ms);
+        start = std::chrono::steady_clock::now();
+        stop_source.request_stop();
+        EXPECT_THROW(future.get(), SearchCancelled);
+        EXPECT_LT(std::chrono::steady_clock::now() - start, 2s);
+        EXPECT_EQ(progress->phase, KeyGenPhase::searching_primes);
+
+        progress = std::make_shared<KeyGenProgress>();
+        auto [public_key, private_key] = rsa_manager.generate_key_pair_async(512, {.progress = progress}).get();
+        EXPECT_EQ(progress->phase, KeyGenPhase::done);
+        EXPECT_EQ(progress->primes_found, 2);
+        EXPECT_GE(progress->candidates, 2);
+        EXPECT_EQ(public_key.n, rsa_manager.public_key.n);
+        EXPECT_EQ(rsa_manager.decrypt(rsa_manager.encrypt(a)), a);
+    }
+}
+
+TEST(RSATest, BatchDecryptTest) {
+    RSA<BigInt> rsa_manager;
+    auto [public_key, private_key] = rsa_manager.generate_key_pair(1024, KeyGenOptions{.batch_exponents = {3, 5, 7, 11, 13}});
+    ASSERT_EQ(rsa_manager.batch_exponents.size(), 5);
+    EXPECT_EQ(public_key.e, BigInt(3));
+
+    std::vector<BigInt> messages, ciphers;
+    for (size_t i = 0; i < 5; i++) {
+        messages.push_back(PrimeGenerator<BigInt>::random_odd_integer(200));
+        ciphers.push_back(rsa_manager.batch_encrypt(messages.back(), i));
+    }
+    EXPECT_EQ(rsa_manager.decrypt(ciphers[0]), messages[0]);
+
+    // every batch size, including odd ones and a single cipher
+    for (size_t count = 1; count <= 5; count++) {
+        std::vector<BigInt> batch(ciphers.begin(), ciphers.begin() + count);
+        auto decrypted = rsa_manager.batch_decrypt(batch);
+        EXPECT_EQ(decrypted, std::vector<BigInt>(messages.begin(), messages.begin() + count)) << count;
+    }
+
+    // 0 and a multiple of p have no inverse mod n, they are decrypted outside the tree
+    std::vector<BigInt> odd_batch = {ciphers[0], BigInt(0), ciphers[2], rsa_manager.batch_encrypt(private_key.p, 3)};
+    auto decrypted = rsa_manager.batch_decrypt(odd_batch);
+    EXPECT_EQ(decrypted, (std::vector<BigInt>{messages[0], BigInt(0), messages[2], private_key.p}));
+
+    // the exponents survive a key file, and keys read without them drop the old ones
+    std::stringstream file;
+    write_key(file, rsa_manager);
+    RSA<BigInt> reader;
+    read_key(file, reader);
+    EXPECT_EQ(reader.batch_exponents, rsa_manager.batch_exponents);
+    EXPECT_EQ(reader.batch_decrypt(ciphers), messages);
+
+    RSA<BigInt> other;
+    other.generate_key_pair(1024);
+    std::stringstream other_file;
+    write_key(other_file, other);
+    read_key(other_file, reader);
+    EXPECT_TRUE(reader.batch_exponents.empty());
+
+    // exponents left over from keys assigned directly are refused instead of giving wrong messages
+    RSA<BigInt> assigned = rsa_manager;
+    assigned.public_key = other.public_key;
+    assigned.private_key = other.private_key;
+    EXPECT_THROW(assigned.batch_decrypt({ciphers[0]}), std::invalid_argument);
+
+    EXPECT_THROW(rsa_manager.batch_decrypt(std::vector<BigInt>(6, BigInt(2))), std::invalid_argument);
+    EXPECT_THROW(rsa_manager.generate_key_pair(512, KeyGenOptions{.batch_exponents = {3, 9}}), std::invalid_argument);
+    EXPECT_THROW(rsa_manager.generate_key_pair(512, KeyGenOptions{.batch_exponents = {4, 5}}), std::invalid_argument);
+}
+
+TEST(RSATest, BlindingTest) {
+    RSA<BigInt> rsa_manager;
+    rsa_manager.generate_key_pair(512);
+    BigInt a("0x20536f6d652054657874204865726520");
+    BigInt expected = BigInt::fast_odd_exp_mod(a, rsa_manager.private_key.d, rsa_manager.private_key.n);
+
+    // the pair is squared after every use, the results stay the same
+    for (int i = 0; i < 5; i++) {
+        EXPECT_EQ(rsa_manager.sign(a), expected);
+    }
+    std::thread([&] { EXPECT_EQ(rsa_manager.sign(a), expected); }).join();
+    EXPECT_TRUE(rsa_manager.verify(a, rsa_manager.sign(a)));
+    EXPECT_EQ(rsa_manager.decrypt(rsa_manager.encrypt(a)), a);
+
+    // a new key on the same object gets a pair of its own
+    rsa_manager.generate_key_pair(512, 3);
+    EXPECT_EQ(rsa_manager.sign(a), BigInt::fast_odd_exp_mod(a, rsa_manager.private_key.d, rsa_manager.private_key.n));
+
+    rsa_manager.blinding = false;
+    EXPECT_EQ(rsa_manager.decrypt(rsa_manager.encrypt(a)), a);
+}
@@ -0,0 +1,79 @@
+#include <random>
+
+#include "gtest/gtest.h"
+
+#include "sha256.hpp"
+
+static std::string to_hex(const Sha256::Digest& digest) {
+    static constexpr char digits[] = "0123456789abcdef";
+    std::string result;
+    for (uint8_t byte: digest) {
+        result += digits[byte >> 4];
+        result += digits[byte & 0xf];
+    }
+    return result;
+}
+
+TEST(Sha256Test, KnownAnswerTest) {
+    std::vector<std::pair<std::string, std::string>> vectors = {
+            {"", "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"},
+            {"abc", "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"},
+            {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq", "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"},
+            {std::string(1000000, 'a'), "cdc76e5c9914fb9281a1c7e284d73e67f1809a48a497200e046d39ccc7112cd0"},
+    };
+
+    for (bool extensions: {false, true}) {
+        Sha256::use_cpu_extensions = extensions;
+        for (const auto& [message, expected]: vectors) {
+            EXPECT_EQ(to_hex(Sha256::hash(message)), expected) << extensions;
+        }
+
+        // the same input fed in uneven pieces
+        Sha256 sha;
+        const std::string& message = vectors[3].first;
+        for (size_t offset = 0, piece = 1; offset < message.size(); offset += piece, piece = piece * 3 % 1000 + 1) {
+            sha.update(message.data() + offset, std::min(piece, message.size() - offset));
+        }
+        EXPECT_EQ(to_hex(sha.finish()), vectors[3].second) << extensions;
+    }
+    Sha256::use_cpu_extensions = true;
+}
+
+TEST(Sha256Test, HashManyTest) {
+    // lengths around the padding boundaries, in groups that do not fill all lanes
+    std::mt19937 gen(7);
+    std::vector<std::string> storage;
+    for (size_t length: {0, 1, 55, 56, 63, 64, 65, 119, 120, 128, 1000, 3, 4096, 17}) {
+        std::string message(length, '\0');
+        for (auto& c: message) c = static_cast<char>(gen());
+        storage.push_back(std::move(message));
+    }
+
+    for (size_t count: {1, 7, 8, 9, 14}) {
+        std::vector<std::string_view> messages(storage.begin(), storage.begin() + count);
+        for (bool extensions: {false, true}) {
+            Sha256::use_cpu_extensions = extensions;
+            auto digests = Sha256::hash_many(messages);
+            ASSERT_EQ(digests.size(), count);
+            for (size_t i = 0; i < count; i++) {
+                Sha256::use_cpu_extensions = false;
+                EXPECT_EQ(digests[i], Sha256::hash(messages[i])) << count << " " << i;
+                Sha256::use_cpu_extensions = extensions;
+            }
+        }
+
+#if defined(RSA_SHA256_X86)
+        // the AVX2 lanes directly, hash_many prefers SHA-NI where it exists
+        if (Sha256::has_avx2()) {
+            std::vector<Sha256::Digest> digests(count);
+            for (size_t i = 0; i < count; i += Sha256::lanes) {
+                Sha256::hash_lanes(messages.data() + i, std::min(Sha256::lanes, count - i), digests.data() + i);
+            }
+            for (size_t i = 0; i < count; i++) {
+                EXPECT_EQ(digests[i], Sha256::hash(messages[i])) << count << " " << i;
+            }
+        }
+#endif
+    }
+    Sha256::use_cpu_extensions = true;
+}
@@ -0,0 +1,66 @@
+#include "gtest/gtest.h"
+
+#include "verification_cache.hpp"
+
+TEST(VerificationCacheTest, VerifyUnderManyKeys) {
+    std::vector<RSA<BigInt>> signers(3);
+    for (auto& signer: signers) signer.generate_key_pair(512);
+
+    VerificationCache<BigInt> cache(8, 2);
+    for (int round = 0; round < 3; round++) {
+        for (auto& signer: signers) {
+            BigInt signature = signer.sign_message("Some Text Here");
+            EXPECT_TRUE(cache.verify_message(signer.public_key, "Some Text Here", signature));
+            EXPECT_FALSE(cache.verify_message(signer.public_key, "Other Text", signature));
+            EXPECT_FALSE(cache.verify_message(signer.public_key, "Some Text Here", signature + signer.public_key.n));
+
+            BigInt digest("0x123456789abcdef");
+            EXPECT_TRUE(cache.verify(signer.public_key, digest, signer.sign(digest)));
+        }
+    }
+
+    // one miss per key, every later lookup hits
+    auto metrics = cache.metrics();
+    EXPECT_EQ(metrics.misses, 3);
+    EXPECT_EQ(metrics.hits, 3 * 3 * 3 - 3);
+    EXPECT_EQ(metrics.evictions, 0);
+    EXPECT_EQ(cache.size(), 3);
+}
+
+TEST(VerificationCacheTest, RejectMalformedModulus) {
+    VerificationCache<BigInt> cache;
+    RSA<BigInt>::PublicKey key{BigInt(0), BigInt(65537)};
+    BigInt digest("0x123456789abcdef");
+
+    for (auto n: {BigInt(0), BigInt(1), BigInt("0x123456789abcdef0")}) {
+        key.n = n;
+        EXPECT_FALSE(cache.verify(key, digest, BigInt(0)));
+        EXPECT_THROW(cache.context(n), std::invalid_argument);
+    }
+    EXPECT_EQ(cache.size(), 0);
+    EXPECT_EQ(cache.metrics().misses, 0);
+}
+
+TEST(VerificationCacheTest, EvictLeastRecentlyUsed) {
+    VerificationCache<BigInt> cache(2, 1);
+    BigInt a("0x10001"), b("0x20001"), c("0x30001");
+
+    auto kept = cache.context(a);
+    cache.context(b);
+    cache.context(a);
+    cache.context(c);  // evicts b, a was used more recently
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.metrics().evictions, 1);
+
+    cache.context(a);
+    EXPECT_EQ(cache.metrics().hits, 2);
+    cache.context(b);
+    EXPECT_EQ(cache.metrics().misses, 4);
+
+    // contexts handed out stay valid after eviction, also when filled inside an ArenaScope
+    cache.context(c);
+    ArenaScope::run([&] { cache.context(BigInt("0x40001")); });
+    ArenaScope::run([&] { BigInt other = BigInt("0x123456789") * BigInt("0x987654321"); });
+    EXPECT_EQ(cache.context(BigInt("0x40001"))->mod, BigInt("0x40001"));
+    EXPECT_EQ(kept->pow(BigInt(3), BigInt(5)), BigInt(243));
+}